@@ -32,14 +32,31 @@
 
 #include "step.h"
 #include "point.h"
+#include "command.h"
 
 class AbstractStepper
 {
 public:
-    virtual void startNewLine(Point &currentPosition, String &arguments) = 0;
+    virtual void startNewLine(Point &currentPosition, const Command &command) = 0;
     virtual bool hasStep() = 0;
     virtual Step& step() = 0;
     virtual bool isFastStep() { return false; }
+
+    /**
+     * Fills the given array with up to capacity of the next steps, returning how many were written.  Each step
+     * carries its own speed, so callers don't need to ask isFastStep() per step.
+     */
+    virtual size_t fillSteps(Step *steps, size_t capacity)
+    {
+        size_t count = 0;
+
+        while (count < capacity && this->hasStep()) {
+            Step &next = this->step();
+            steps[count++].setStepsWithSpeed(next.getRadiusStep(), next.getAzimuthStep(), this->isFastStep());
+        }
+
+        return count;
+    }
 };
 
 #endif
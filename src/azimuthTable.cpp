@@ -0,0 +1,103 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "azimuthTable.h"
+#include <stddef.h>
+#include <new>
+
+AzimuthTable::AzimuthTable()
+    : azimuthStepSize(0),
+      fullCircleSteps(0),
+      halfCircleSteps(0),
+      quarterCircleSteps(0),
+      cosines(NULL),
+      sines(NULL)
+{
+}
+
+AzimuthTable::~AzimuthTable()
+{
+  this->release();
+}
+
+void AzimuthTable::release()
+{
+  delete[] cosines;
+  delete[] sines;
+  cosines = NULL;
+  sines = NULL;
+  fullCircleSteps = 0;
+  halfCircleSteps = 0;
+  quarterCircleSteps = 0;
+}
+
+void AzimuthTable::calibrate(double azimuthStepSize)
+{
+  if (azimuthStepSize == this->azimuthStepSize && this->isAvailable()) return;
+
+  this->release();
+  this->azimuthStepSize = azimuthStepSize;
+  if (azimuthStepSize <= 0) return;
+
+  // The table relies on the circle being an even number of steps, so that index N - k mirrors index k, and index
+  // N / 2 - k mirrors index k about the quarter turn
+  long steps = (long)round((2 * PI) / azimuthStepSize);
+  if (steps < 4 || steps > MAX_AZIMUTH_TABLE_STEPS || steps % 2 != 0 || abs(steps * azimuthStepSize - 2 * PI) > azimuthStepSize * 0.001) return;
+
+  long entries = steps / 4 + 1;
+  cosines = new (std::nothrow) double[entries];
+  sines = new (std::nothrow) double[entries];
+  if (cosines == NULL || sines == NULL) {
+    this->release();
+    return;
+  }
+
+  for (long i = 0; i < entries; i++) {
+    cosines[i] = cos(i * azimuthStepSize);
+    sines[i] = sin(i * azimuthStepSize);
+  }
+
+  fullCircleSteps = steps;
+  halfCircleSteps = steps / 2;
+  quarterCircleSteps = steps / 4;
+}
+
+bool AzimuthTable::isAvailable() const
+{
+  return fullCircleSteps > 0;
+}
+
+void AzimuthTable::lookup(long azimuthIndex, double &cosine, double &sine) const
+{
+  long index = azimuthIndex % fullCircleSteps;
+  if (index < 0) index += fullCircleSteps;
+
+  // The lower half of the circle mirrors the upper half's sines, and the second quarter mirrors the first's cosines
+  bool negateSine = index > halfCircleSteps;
+  if (negateSine) index = fullCircleSteps - index;
+  bool negateCosine = index > quarterCircleSteps;
+  if (negateCosine) index = halfCircleSteps - index;
+
+  cosine = negateCosine ? -cosines[index] : cosines[index];
+  sine = negateSine ? -sines[index] : sines[index];
+}
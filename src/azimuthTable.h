@@ -0,0 +1,59 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_AZIMUTHTABLE_H_
+#define _POLARPLOTTERCORE_AZIMUTHTABLE_H_
+
+#ifndef __IN_TEST__
+#include <Arduino.h>
+#else
+#include "mockArduino.h"
+#endif
+#include "math.h"
+
+// Largest full circle (in azimuth steps) that a table will be built for.  Only the first quarter turn is stored, and
+// mirrored for the rest of the circle, so the table takes (MAX_AZIMUTH_TABLE_STEPS / 4 + 1) * 2 doubles (32 KB) at
+// most, and about 19 KB for a typical 4810 step circle.
+#define MAX_AZIMUTH_TABLE_STEPS 8192
+
+class AzimuthTable
+{
+private:
+  double azimuthStepSize;
+  long fullCircleSteps;
+  long halfCircleSteps;
+  long quarterCircleSteps;
+  double *cosines;
+  double *sines;
+
+  void release();
+
+public:
+  AzimuthTable();
+  ~AzimuthTable();
+  void calibrate(double azimuthStepSize);
+  bool isAvailable() const;
+  void lookup(long azimuthIndex, double &cosine, double &sine) const;
+};
+
+#endif
@@ -27,15 +27,43 @@
 #include <iomanip>
 #endif
 
+AzimuthTable BaseStepper::azimuthTable;
+const int BaseStepper::candidateRadiusSteps[NEXT_POINT_COUNT] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+const int BaseStepper::candidateAzimuthSteps[NEXT_POINT_COUNT] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+
+BaseStepper::BaseStepper()
+    : lookaheadDepth(0),
+      maxDeviation(0),
+      segmentTolerance(0)
+{
+}
+
 void BaseStepper::calibrate(double radiusStepSize, double azimuthStepSize)
 {
     this->radiusStepSize = radiusStepSize;
     this->azimuthStepSize = azimuthStepSize;
+    this->inverseAzimuthStepSize = 1 / azimuthStepSize;
+    this->cosAzimuthStep = cos(azimuthStepSize);
+    this->sinAzimuthStep = sin(azimuthStepSize);
+    this->halfCircleAzimuthSteps = (long)round(PI / azimuthStepSize);
+    azimuthTable.calibrate(azimuthStepSize);
+}
+
+void BaseStepper::setLookahead(int depth, double maxDeviation)
+{
+    this->lookaheadDepth = depth < 0 ? 0 : (depth > MAX_LOOKAHEAD_DEPTH ? MAX_LOOKAHEAD_DEPTH : depth);
+    this->maxDeviation = maxDeviation;
+}
+
+void BaseStepper::setSegmentTolerance(double tolerance)
+{
+    this->segmentTolerance = tolerance < 0 ? 0 : tolerance;
 }
 
 bool BaseStepper::hasStep() {
     if (needNextStep) {
-        currentPosition.cloneFrom(nextPosition);
+        currentRadiusIndex = nextRadiusIndex;
+        currentAzimuthIndex = nextAzimuthIndex;
 
         this->computeNextStep();
 
@@ -57,26 +85,127 @@ Step &BaseStepper::step() {
     return nextStep;
 }
 
-void BaseStepper::startNewLine(Point &currentPosition, String &arguments) {
+size_t BaseStepper::fillSteps(Step *steps, size_t capacity) {
+    if (segmentTolerance > 0) return this->fillSegments(steps, capacity);
+
+    const bool fast = this->isFastStep();
+    size_t count = 0;
+
+    while (count < capacity) {
+        if (needNextStep) {
+            currentRadiusIndex = nextRadiusIndex;
+            currentAzimuthIndex = nextAzimuthIndex;
+
+            this->computeNextStep();
+
+            currentDistanceToFinish = nextDistanceToFinish;
+            needNextStep = false;
+        }
+
+        if (!nextStep.hasStep()) break;
+
+        steps[count++].setStepsWithSpeed(nextStep.getRadiusStep(), nextStep.getAzimuthStep(), fast);
+        needNextStep = true;
+    }
+
+    return count;
+}
+
+size_t BaseStepper::fillSegments(Step *steps, size_t capacity) {
+    const bool fast = this->isFastStep();
+    size_t count = 0;
+    bool segmentOpen = false;
+    long segmentRadiusIndex = 0, segmentAzimuthIndex = 0;
+    long segmentRadiusSteps = 0, segmentAzimuthSteps = 0;
+
+    while (true) {
+        if (needNextStep) {
+            currentRadiusIndex = nextRadiusIndex;
+            currentAzimuthIndex = nextAzimuthIndex;
+
+            this->computeNextStep();
+
+            currentDistanceToFinish = nextDistanceToFinish;
+            needNextStep = false;
+        }
+
+        if (!nextStep.hasStep()) break;
+
+        long radiusSteps = segmentRadiusSteps + nextStep.getRadiusStep();
+        long azimuthSteps = segmentAzimuthSteps + nextStep.getAzimuthStep();
+
+        if (segmentOpen && !this->isSegmentWithinTolerance(segmentRadiusIndex, segmentAzimuthIndex, radiusSteps, azimuthSteps)) {
+            steps[count++].setStepsWithSpeed(segmentRadiusSteps, segmentAzimuthSteps, fast);
+            segmentOpen = false;
+        }
+
+        if (!segmentOpen) {
+            // The step stays pending for the next call when there is no room to start a segment with it
+            if (count >= capacity) break;
+
+            segmentOpen = true;
+            segmentRadiusIndex = currentRadiusIndex;
+            segmentAzimuthIndex = currentAzimuthIndex;
+            radiusSteps = nextStep.getRadiusStep();
+            azimuthSteps = nextStep.getAzimuthStep();
+        }
+
+        segmentRadiusSteps = radiusSteps;
+        segmentAzimuthSteps = azimuthSteps;
+        needNextStep = true;
+    }
+
+    if (segmentOpen) steps[count++].setStepsWithSpeed(segmentRadiusSteps, segmentAzimuthSteps, fast);
+
+    return count;
+}
+
+bool BaseStepper::isSegmentWithinTolerance(long radiusIndex, long azimuthIndex, long radiusSteps, long azimuthSteps) {
+    // Both ends are lattice positions the planner already chose, so only the interior of the sub-spiral is checked
+    CandidateBatch batch;
+
+    for (int i = 0; i < SEGMENT_SAMPLE_COUNT; i++) {
+        double fraction = (double)(i + 1) / (SEGMENT_SAMPLE_COUNT + 1);
+        double sampleRadius = (radiusIndex + radiusSteps * fraction) * radiusStepSize;
+        double cosine, sine;
+
+        this->findAzimuthCosSin(azimuthIndex + azimuthSteps * fraction, cosine, sine);
+        batch.x[i] = sampleRadius * cosine;
+        batch.y[i] = sampleRadius * sine;
+    }
+
+    this->evaluateCandidates(batch, SEGMENT_SAMPLE_COUNT);
+
+    for (int i = 0; i < SEGMENT_SAMPLE_COUNT; i++) {
+        if (batch.deviation[i] > segmentTolerance) return false;
+    }
+
+    return true;
+}
+
+void BaseStepper::startNewLine(Point &currentPosition, const Command &command) {
     this->snapPointToClosestPossiblePosition(currentPosition);
     this->start.cloneFrom(currentPosition);
-    this->currentPosition.cloneFrom(currentPosition);
-    this->nextPosition.cloneFrom(currentPosition);
+    currentRadiusIndex = nextRadiusIndex = (long)round(currentPosition.getRadius() / radiusStepSize);
+    currentAzimuthIndex = nextAzimuthIndex = (long)round(currentPosition.getAzimuth() / azimuthStepSize);
 
-    if (!this->parseArgumentsAndSetFinish(currentPosition, arguments)) {
+    if (!this->parseArgumentsAndSetFinish(currentPosition, command)) {
         currentDistanceToFinish = 0;
         nextStep.setSteps(0, 0);
         nextDistanceToFinish = 0;
+        needNextStep = false;
         return;
     }
 
+    finishRadiusIndex = (long)round(finish.getRadius() / radiusStepSize);
+    finishAzimuthIndex = (long)round(finish.getAzimuth() / azimuthStepSize);
     currentDistanceToFinish = this->findDistanceFromPointOnLineToFinish(currentPosition);
 
     // If we are at the center and need to rotate towards the end, we shouldn't use the default calculation to determine next position
-    if (currentPosition.getRadius() < (radiusStepSize * 0.1)) {
-        originExitAzimuth = this->determineStartingAzimuthFromCenter();
+    if (currentRadiusIndex == 0) {
+        exitAzimuthIndex = (long)round(this->determineStartingAzimuthFromCenter() / azimuthStepSize);
     } else {
-        originExitAzimuth = currentPosition.getAzimuth();
+        exitAzimuthIndex = currentAzimuthIndex;
     }
 
 #ifdef __SHOW_STEP_DETAILS__
@@ -85,7 +214,7 @@ void BaseStepper::startNewLine(Point &currentPosition, String &arguments) {
     double x = finish.getX();
     double y = finish.getY();
 
-    std::cout << std::setprecision(8) << "    Finish: (" << r << "," << a << "," << x << "," << y << ") - " << std::setprecision(14) << currentDistanceToFinish << " - " << originExitAzimuth << std::endl;
+    std::cout << std::setprecision(8) << "    Finish: (" << r << "," << a << "," << x << "," << y << ") - " << std::setprecision(14) << currentDistanceToFinish << " - " << exitAzimuthIndex << std::endl;
 #endif
 
     needNextStep = true;
@@ -97,125 +226,258 @@ void BaseStepper::computeNextStep() {
 }
 
 void BaseStepper::determineNextPositionAndDistance() {
+    nextRadiusIndex = currentRadiusIndex;
+    nextAzimuthIndex = currentAzimuthIndex;
+
     // If we are at the origin and aren't pointed in the right direction, repoint
-    if (currentPosition.getRadius() < (radiusStepSize * 0.1) && abs(originExitAzimuth - currentPosition.getAzimuth()) > (azimuthStepSize * 0.5)) {
-        nextPosition.repoint(currentPosition.getRadius(), originExitAzimuth);
+    if (currentRadiusIndex == 0 && currentAzimuthIndex != exitAzimuthIndex) {
+        nextAzimuthIndex = exitAzimuthIndex;
         nextDistanceToFinish = currentDistanceToFinish;
         return;
     }
 
-    if (abs(currentPosition.getRadius() - finish.getRadius()) <= (radiusStepSize * 0.5) && abs(currentPosition.getAzimuth() - finish.getAzimuth()) <= (azimuthStepSize * 0.5)) {
-        nextPosition.cloneFrom(currentPosition);
-        nextStep.setSteps(0, 0);
+    if (currentRadiusIndex == finishRadiusIndex && currentAzimuthIndex == finishAzimuthIndex) {
         nextDistanceToFinish = 0;
         return;
     }
 
-    this->setupNextPoints();
-    this->findNextClosestPointsOnLine();
-    this->findPointsCloserToFinish();
-
-    if (pointsCloserToFinishCount <= 0) {
+    bool found = lookaheadDepth > 0 ? this->chooseNextPositionWithLookahead() : this->chooseNextPosition();
+    if (!found) {
+        nextRadiusIndex = currentRadiusIndex;
+        nextAzimuthIndex = currentAzimuthIndex;
         nextDistanceToFinish = currentDistanceToFinish;
-        nextPosition.cloneFrom(currentPosition);
         return;
     }
 
-    Point closestPointToLine = pointsCloserToFinish[0];
-    double closestPointDistanceToFinish = pointsCloserToFinishDistance[0];
-    double closestDistanceToLine = this->findDistanceBetweenPoints(closestPointToLine, pointsCloserToFinishOnLine[0]);
+    exitAzimuthIndex = nextAzimuthIndex;
 
-    for (int i = 1; i < pointsCloserToFinishCount; i++) {
-        double distanceToLine = this->findDistanceBetweenPoints(pointsCloserToFinish[i], pointsCloserToFinishOnLine[i]);
+    if (nextRadiusIndex <= 0) {
+        nextRadiusIndex = 0;
+        exitAzimuthIndex = nextAzimuthIndex + halfCircleAzimuthSteps * (nextAzimuthIndex > finishAzimuthIndex ? -1 : 1);
+    }
+}
 
-        if (distanceToLine < closestDistanceToLine) {
-            closestPointToLine = pointsCloserToFinish[i];
-            closestPointDistanceToFinish = pointsCloserToFinishDistance[i];
-            closestDistanceToLine = distanceToLine;
+bool BaseStepper::chooseNextPosition() {
+#ifdef __SHOW_STEP_DETAILS__
+    std::cout << std::setprecision(8) << "    Current: (" << currentRadiusIndex << "," << currentAzimuthIndex << ") - " << std::setprecision(14) << currentDistanceToFinish << std::endl;
+#endif
+    CandidateBatch batch;
+    this->fillCandidates(currentRadiusIndex, currentAzimuthIndex, batch);
+    this->evaluateCandidates(batch, NEXT_POINT_COUNT);
+
+    // Of the candidates that get closer to the finish, take the one closest to the line
+    int closestCandidate = -1;
+    for (int i = 0; i < NEXT_POINT_COUNT; i++) {
+#ifdef __SHOW_STEP_DETAILS__
+        std::cout << std::setprecision(8) << "    Candidate (" << batch.x[i] << "," << batch.y[i] << ") - " << std::setprecision(14) << batch.distanceToFinish[i] << " / " << batch.deviation[i] << std::endl;
+#endif
+        if (currentRadiusIndex + candidateRadiusSteps[i] < 0) continue;
+        if (batch.distanceToFinish[i] >= currentDistanceToFinish) continue;
+
+        if (closestCandidate < 0 || batch.deviation[i] < batch.deviation[closestCandidate]) {
+            closestCandidate = i;
         }
     }
 
-    nextPosition.cloneFrom(closestPointToLine);
-    nextDistanceToFinish = closestPointDistanceToFinish;
-    originExitAzimuth = nextPosition.getAzimuth();
+    if (closestCandidate < 0) {
+        return false;
+    }
+
+    nextRadiusIndex = currentRadiusIndex + candidateRadiusSteps[closestCandidate];
+    nextAzimuthIndex = currentAzimuthIndex + candidateAzimuthSteps[closestCandidate];
+    nextDistanceToFinish = batch.distanceToFinish[closestCandidate];
+    return true;
+}
+
+bool BaseStepper::chooseNextPositionWithLookahead() {
+    LookaheadState beam[LOOKAHEAD_BEAM_WIDTH];
+    LookaheadState expanded[LOOKAHEAD_BEAM_WIDTH * NEXT_POINT_COUNT];
+    LookaheadState best;
+    int beamCount = 1;
+    bool found = false;
+
+    // No step gets further than a diagonal one at the largest radius left to cover, which for a line is at one of its
+    // ends, so the distance left over that is the fewest steps left
+    long furthestRadiusIndex = currentRadiusIndex > finishRadiusIndex ? currentRadiusIndex : finishRadiusIndex;
+    double tangentialLength = furthestRadiusIndex * radiusStepSize * azimuthStepSize;
+    lookaheadStepLength = sqrt(radiusStepSize * radiusStepSize + tangentialLength * tangentialLength);
+
+    beam[0].radiusIndex = currentRadiusIndex;
+    beam[0].azimuthIndex = currentAzimuthIndex;
+    beam[0].firstCandidate = -1;
+    beam[0].steps = 0;
+    beam[0].firstDistanceToFinish = currentDistanceToFinish;
+    beam[0].distanceToFinish = currentDistanceToFinish;
+    beam[0].deviation = 0;
+    beam[0].estimatedSteps = 0;
+
+    for (int depth = 0; depth < lookaheadDepth && beamCount > 0; depth++) {
+        int expandedCount = 0;
+        for (int i = 0; i < beamCount; i++) {
+            this->expandLookaheadState(beam[i], expanded, expandedCount);
+        }
+
+        // Keep the states that look to reach the finish in the fewest steps
+        beamCount = 0;
+        for (int i = 0; i < expandedCount; i++) {
+            LookaheadState &state = expanded[i];
+            bool duplicate = false;
+
+            for (int j = 0; j < beamCount && !duplicate; j++) {
+                duplicate = beam[j].radiusIndex == state.radiusIndex && beam[j].azimuthIndex == state.azimuthIndex;
+            }
+            if (duplicate) continue;
+
+            int position = beamCount;
+            while (position > 0 && this->isBetterLookaheadState(state, beam[position - 1])) {
+                position--;
+            }
+            if (position >= LOOKAHEAD_BEAM_WIDTH) continue;
+
+            int last = beamCount < LOOKAHEAD_BEAM_WIDTH ? beamCount : LOOKAHEAD_BEAM_WIDTH - 1;
+            for (int j = last; j > position; j--) beam[j] = beam[j - 1];
+            beam[position] = state;
+            if (beamCount < LOOKAHEAD_BEAM_WIDTH) beamCount++;
+        }
 
-    if (nextPosition.getRadius() < (radiusStepSize * 0.1)) {
-        double nextA = nextPosition.getAzimuth();
-        nextPosition.repoint(0, nextA);
-        originExitAzimuth = nextA + PI * (nextA > finish.getAzimuth() ? -1 : 1);
+        if (beamCount > 0) {
+            best = beam[0];
+            found = true;
+        }
     }
+
+    // Nothing stays within the allowed deviation, so fall back to the plain closest-to-the-line choice
+    if (!found) return this->chooseNextPosition();
+
+    nextRadiusIndex = currentRadiusIndex + candidateRadiusSteps[best.firstCandidate];
+    nextAzimuthIndex = currentAzimuthIndex + candidateAzimuthSteps[best.firstCandidate];
+    nextDistanceToFinish = best.firstDistanceToFinish;
+    return true;
 }
 
-void BaseStepper::setupNextStepFromNextPosition() {
-    double currentRadiusPlusMargin = currentPosition.getRadius() + radiusStepSize * 0.1;
-    double currentRadiusMinusMargin = currentPosition.getRadius() - radiusStepSize * 0.1;
-    double currentAzimuthPlusMargin = currentPosition.getAzimuth() + azimuthStepSize * 0.1;
-    double currentAzimuthMinusMargin = currentPosition.getAzimuth() - azimuthStepSize * 0.1;
-    long radiusStep = 0, azimuthStep = 0;
+bool BaseStepper::isBetterLookaheadState(LookaheadState &state, LookaheadState &other) {
+    // Fewest steps in all, then the path that kept closest to the line
+    if (state.estimatedSteps != other.estimatedSteps) return state.estimatedSteps < other.estimatedSteps;
+    return state.deviation < other.deviation;
+}
+
+void BaseStepper::expandLookaheadState(LookaheadState &state, LookaheadState *expanded, int &expandedCount) {
+    int originalCount = expandedCount;
 
-    if (nextPosition.getRadius() > currentRadiusPlusMargin || nextPosition.getRadius() < currentRadiusMinusMargin) {
-        radiusStep = (long)round((nextPosition.getRadius() - currentPosition.getRadius()) / radiusStepSize);
+    CandidateBatch batch;
+    this->fillCandidates(state.radiusIndex, state.azimuthIndex, batch);
+    this->evaluateCandidates(batch, NEXT_POINT_COUNT);
+
+    for (int i = 0; i < NEXT_POINT_COUNT; i++) {
+        long radiusIndex = state.radiusIndex + candidateRadiusSteps[i];
+        long azimuthIndex = state.azimuthIndex + candidateAzimuthSteps[i];
+        if (radiusIndex < 0) continue;
+
+        double distanceToFinish = batch.distanceToFinish[i];
+        if (distanceToFinish >= state.distanceToFinish) continue;
+
+        double deviation = batch.deviation[i];
+        if (deviation > maxDeviation) continue;
+
+        LookaheadState &next = expanded[expandedCount++];
+        next.radiusIndex = radiusIndex;
+        next.azimuthIndex = azimuthIndex;
+        next.firstCandidate = state.firstCandidate < 0 ? i : state.firstCandidate;
+        next.steps = state.steps + 1;
+        next.firstDistanceToFinish = state.firstCandidate < 0 ? distanceToFinish : state.firstDistanceToFinish;
+        next.distanceToFinish = distanceToFinish;
+        next.deviation = deviation > state.deviation ? deviation : state.deviation;
+        next.estimatedSteps = next.steps + distanceToFinish / lookaheadStepLength;
     }
-    if (nextPosition.getAzimuth() > currentAzimuthPlusMargin || nextPosition.getAzimuth() < currentAzimuthMinusMargin) {
-        azimuthStep = (long)round((nextPosition.getAzimuth() - currentPosition.getAzimuth()) / azimuthStepSize);
+
+    // A path that can't get any closer (e.g. it reached the finish) carries on unchanged, so it can compete with the longer ones
+    if (expandedCount == originalCount && state.firstCandidate >= 0) {
+        expanded[expandedCount++] = state;
     }
+}
 
-    nextStep.setSteps(radiusStep, azimuthStep);
-    nextPosition.repoint(currentPosition.getRadius() + radiusStep * radiusStepSize,
-                         currentPosition.getAzimuth() + azimuthStep * azimuthStepSize);
+void BaseStepper::setupNextStepFromNextPosition() {
+    nextStep.setSteps(nextRadiusIndex - currentRadiusIndex, nextAzimuthIndex - currentAzimuthIndex);
 }
 
-void BaseStepper::setupNextPoints() {
-    double curR = currentPosition.getRadius();
-    double curA = currentPosition.getAzimuth();
-#ifdef __SHOW_STEP_DETAILS__
-    double x = currentPosition.getX();
-    double y = currentPosition.getY();
+void BaseStepper::fillCandidates(long radiusIndex, long azimuthIndex, CandidateBatch &batch) {
+    double cosines[3], sines[3];
+    double candidateCosines[NEXT_POINT_COUNT], candidateSines[NEXT_POINT_COUNT], candidateRadii[NEXT_POINT_COUNT];
+    this->findAzimuthNeighbours(azimuthIndex, cosines, sines);
 
-    std::cout << std::setprecision(8) << "    Current: (" << curR << "," << curA << "," << x << "," << y << ") - " << std::setprecision(14) << currentDistanceToFinish << std::endl;
-#endif
+    for (int i = 0; i < NEXT_POINT_COUNT; i++) {
+        candidateCosines[i] = cosines[candidateAzimuthSteps[i] + 1];
+        candidateSines[i] = sines[candidateAzimuthSteps[i] + 1];
+        candidateRadii[i] = (radiusIndex + candidateRadiusSteps[i]) * radiusStepSize;
+    }
 
-    nextPoints[0].repoint(curR - radiusStepSize, curA - azimuthStepSize);
-    nextPoints[1].repoint(curR - radiusStepSize, curA);
-    nextPoints[2].repoint(curR - radiusStepSize, curA + azimuthStepSize);
-    nextPoints[3].repoint(curR, curA - azimuthStepSize);
-    nextPoints[4].repoint(curR, curA + azimuthStepSize);
-    nextPoints[5].repoint(curR + radiusStepSize, curA - azimuthStepSize);
-    nextPoints[6].repoint(curR + radiusStepSize, curA);
-    nextPoints[7].repoint(curR + radiusStepSize, curA + azimuthStepSize);
+    for (int i = 0; i < NEXT_POINT_COUNT; i++) {
+        batch.x[i] = candidateRadii[i] * candidateCosines[i];
+        batch.y[i] = candidateRadii[i] * candidateSines[i];
+    }
 }
 
-void BaseStepper::findNextClosestPointsOnLine() {
-    for (int i = 0; i < NEXT_POINT_COUNT; i++) {
-        this->setClosestPointOnLine(nextPoints[i], nextClosestPointsOnLine[i]);
+int BaseStepper::fillHeadingCandidates(long radiusIndex, double cosines[3], double sines[3], double headingX, double headingY,
+                                       CandidateBatch &batch, int radiusSteps[HEADING_POINT_COUNT], int azimuthSteps[HEADING_POINT_COUNT]) {
+    // The heading's radial and tangential parts, at the azimuth of cosines[1] and sines[1], say which way each axis
+    // has to step to move along it.  Only the neighbours that way are filled in, up to HEADING_POINT_COUNT of them.
+    double radial = headingX * cosines[1] + headingY * sines[1];
+    double tangential = headingY * cosines[1] - headingX * sines[1];
+    int radiusStep = radial > 0 ? 1 : (radial < 0 ? -1 : 0);
+    int azimuthStep = tangential > 0 ? 1 : (tangential < 0 ? -1 : 0);
+    if (radiusIndex + radiusStep < 0) radiusStep = 0;
+
+    int count = 0;
+    if (radiusStep != 0) {
+        radiusSteps[count] = radiusStep;
+        azimuthSteps[count++] = 0;
+    }
+    if (azimuthStep != 0) {
+        radiusSteps[count] = 0;
+        azimuthSteps[count++] = azimuthStep;
     }
+    if (radiusStep != 0 && azimuthStep != 0) {
+        radiusSteps[count] = radiusStep;
+        azimuthSteps[count++] = azimuthStep;
+    }
+
+    for (int i = 0; i < count; i++) {
+        double candidateRadius = (radiusIndex + radiusSteps[i]) * radiusStepSize;
+        batch.x[i] = candidateRadius * cosines[azimuthSteps[i] + 1];
+        batch.y[i] = candidateRadius * sines[azimuthSteps[i] + 1];
+    }
+
+    return count;
 }
 
-void BaseStepper::findPointsCloserToFinish() {
-    pointsCloserToFinishCount = 0;
+void BaseStepper::evaluateCandidates(CandidateBatch &batch, int count) {
+    // Generic version, one point at a time through the geometry of the subclass
+    Point point, closestPoint;
 
-    for (int i = 0; i < NEXT_POINT_COUNT; i++) {
-        double distanceToFinish = this->findDistanceFromPointOnLineToFinish(nextClosestPointsOnLine[i]);
-#ifdef __SHOW_STEP_DETAILS__
-    double rC = nextClosestPointsOnLine[i].getRadius();
-    double aC = nextClosestPointsOnLine[i].getAzimuth();
-    double xC = nextClosestPointsOnLine[i].getX();
-    double yC = nextClosestPointsOnLine[i].getY();
-    double rN = nextPoints[i].getRadius();
-    double aN = nextPoints[i].getAzimuth();
-    double xN = nextPoints[i].getX();
-    double yN = nextPoints[i].getY();
-    bool closer = distanceToFinish < currentDistanceToFinish;
-
-    std::cout << std::setprecision(8) << "    Distance to (" << rN << "," << aN << "," << xN << "," << yN << ") / (" << rC << "," << aC << "," << xC << "," << yC << ") - " << std::setprecision(14) << distanceToFinish << " / " << closer << std::endl;
-#endif
-        if (distanceToFinish < currentDistanceToFinish) {
-            pointsCloserToFinish[pointsCloserToFinishCount] = nextPoints[i];
-            pointsCloserToFinishOnLine[pointsCloserToFinishCount] = nextClosestPointsOnLine[i];
-            pointsCloserToFinishDistance[pointsCloserToFinishCount] = distanceToFinish;
-            pointsCloserToFinishCount++;
-        }
+    for (int i = 0; i < count; i++) {
+        point.cartesianRepoint(batch.x[i], batch.y[i]);
+        this->setClosestPointOnLine(point, closestPoint);
+        batch.distanceToFinish[i] = this->findDistanceFromPointOnLineToFinish(closestPoint);
+        batch.deviation[i] = this->findDistanceBetweenPoints(point, closestPoint);
+    }
+}
+
+void BaseStepper::findAzimuthNeighbours(long azimuthIndex, double cosines[3], double sines[3]) {
+    // Fills in the cos/sin of azimuth - step, azimuth, and azimuth + step
+    if (azimuthTable.isAvailable()) {
+        azimuthTable.lookup(azimuthIndex - 1, cosines[0], sines[0]);
+        azimuthTable.lookup(azimuthIndex, cosines[1], sines[1]);
+        azimuthTable.lookup(azimuthIndex + 1, cosines[2], sines[2]);
+        return;
     }
+
+    double azimuth = azimuthIndex * azimuthStepSize;
+    cosines[1] = cos(azimuth);
+    sines[1] = sin(azimuth);
+    cosines[0] = cosines[1] * cosAzimuthStep + sines[1] * sinAzimuthStep;
+    sines[0] = sines[1] * cosAzimuthStep - cosines[1] * sinAzimuthStep;
+    cosines[2] = cosines[1] * cosAzimuthStep - sines[1] * sinAzimuthStep;
+    sines[2] = sines[1] * cosAzimuthStep + cosines[1] * sinAzimuthStep;
 }
 
 void BaseStepper::orientPoint(Point &referencePoint, Point &pointToOrient) {
@@ -242,6 +504,26 @@ void BaseStepper::snapPointToClosestPossiblePosition(Point &point) {
   point.repoint(radius, azimuth);
 }
 
+void BaseStepper::findAzimuthCosSin(double azimuthIndex, double &cosine, double &sine) {
+    if (!azimuthTable.isAvailable()) {
+        cosine = cos(azimuthIndex * azimuthStepSize);
+        sine = sin(azimuthIndex * azimuthStepSize);
+        return;
+    }
+
+    // Rotate the nearest table entry by the leftover fraction of a step, which is small enough for a short series
+    long wholeIndex = (long)floor(azimuthIndex + 0.5);
+    double delta = (azimuthIndex - wholeIndex) * azimuthStepSize;
+    double deltaSquared = delta * delta;
+    double cosDelta = 1 - deltaSquared * (0.5 - deltaSquared / 24);
+    double sinDelta = delta * (1 - deltaSquared / 6);
+    double cosWhole, sinWhole;
+
+    azimuthTable.lookup(wholeIndex, cosWhole, sinWhole);
+    cosine = cosWhole * cosDelta - sinWhole * sinDelta;
+    sine = sinWhole * cosDelta + cosWhole * sinDelta;
+}
+
 double BaseStepper::findDistanceBetweenPoints(Point &first, Point &second) {
     double deltaX = first.getX() - second.getX();
     double deltaY = first.getY() - second.getY();
@@ -25,53 +25,117 @@
 #define _POLARPLOTTERCORE_BASESTEPPER_H_
 
 #include "abstractStepper.h"
+#include "azimuthTable.h"
 #define NEXT_POINT_COUNT 8
+// A heading picks one way for each axis to step, leaving a radius step, an azimuth step and both
+#define HEADING_POINT_COUNT 3
+#define MAX_LOOKAHEAD_DEPTH 6
+#define LOOKAHEAD_BEAM_WIDTH 4
+// Fractions along a polar-linear segment where its deviation from the true geometry is sampled
+#define SEGMENT_SAMPLE_COUNT 3
 
+// Candidate positions laid out as parallel arrays rather than Points, so the per-candidate geometry is a few plain
+// loops over doubles that the compiler can vectorize (SSE/AVX or NEON on host builds)
+struct alignas(32) CandidateBatch
+{
+    double x[NEXT_POINT_COUNT];
+    double y[NEXT_POINT_COUNT];
+    double distanceToFinish[NEXT_POINT_COUNT];
+    double deviation[NEXT_POINT_COUNT];
+};
+
+struct LookaheadState
+{
+    long radiusIndex;
+    long azimuthIndex;
+    int firstCandidate;
+    int steps;
+    double firstDistanceToFinish;
+    double distanceToFinish;
+    double deviation;
+    // The steps taken, plus the fewest it could take from there to the finish
+    double estimatedSteps;
+};
+
+// Positions are tracked as integer (radius step, azimuth step) pairs on the step lattice, the same values the motors
+// count.  Points are only built for the candidates whose geometry is needed, and each emitted step is the exact
+// difference between two lattice positions, so nothing drifts over a long drawing.
 class BaseStepper : public AbstractStepper
 {
 protected:
     double radiusStepSize;
     double azimuthStepSize;
+    double inverseAzimuthStepSize;
+    double cosAzimuthStep;
+    double sinAzimuthStep;
+    long halfCircleAzimuthSteps;
+
+    // Shared by all steppers, since they are all calibrated with the same azimuth step size
+    static AzimuthTable azimuthTable;
+    static const int candidateRadiusSteps[NEXT_POINT_COUNT];
+    static const int candidateAzimuthSteps[NEXT_POINT_COUNT];
 
     Point start;
-    double originExitAzimuth;
     Point finish;
+    long finishRadiusIndex;
+    long finishAzimuthIndex;
+    long exitAzimuthIndex;
 
-    Point currentPosition;
+    long currentRadiusIndex;
+    long currentAzimuthIndex;
     double currentDistanceToFinish;
 
-    Point nextPosition;
+    long nextRadiusIndex;
+    long nextAzimuthIndex;
     Step nextStep;
     double nextDistanceToFinish;
     bool needNextStep;
 
-    Point nextPoints[NEXT_POINT_COUNT];
-    Point nextClosestPointsOnLine[NEXT_POINT_COUNT];
-    Point pointsCloserToFinish[NEXT_POINT_COUNT];
-    Point pointsCloserToFinishOnLine[NEXT_POINT_COUNT];
-    double pointsCloserToFinishDistance[NEXT_POINT_COUNT];
-    int pointsCloserToFinishCount;
+    // With a lookahead depth above zero, each step is the first move of the path (found with a beam search) that
+    // looks to reach the finish in the fewest steps, without ever straying more than maxDeviation from the line.  It
+    // is off by default, as it saves few steps for the time it takes.
+    int lookaheadDepth;
+    double maxDeviation;
+    double lookaheadStepLength;
+
+    // With a segment tolerance above zero, fillSteps merges consecutive lattice steps into polar-linear segments
+    // (Archimedean sub-spirals, which the coordinator interpolates on its own) for as long as the segment stays
+    // within that distance of the true geometry
+    double segmentTolerance;
 
     virtual void computeNextStep();
     virtual void determineNextPositionAndDistance();
+    virtual bool chooseNextPosition();
+    virtual bool chooseNextPositionWithLookahead();
+    virtual bool isBetterLookaheadState(LookaheadState &state, LookaheadState &other);
+    virtual void expandLookaheadState(LookaheadState &state, LookaheadState *expanded, int &expandedCount);
     virtual void setupNextStepFromNextPosition();
-    virtual void setupNextPoints();
-    virtual void findNextClosestPointsOnLine();
-    virtual void findPointsCloserToFinish();
+    void fillCandidates(long radiusIndex, long azimuthIndex, CandidateBatch &batch);
+    int fillHeadingCandidates(long radiusIndex, double cosines[3], double sines[3], double headingX, double headingY,
+                              CandidateBatch &batch, int radiusSteps[HEADING_POINT_COUNT], int azimuthSteps[HEADING_POINT_COUNT]);
+    virtual void evaluateCandidates(CandidateBatch &batch, int count);
+    virtual void findAzimuthNeighbours(long azimuthIndex, double cosines[3], double sines[3]);
+    virtual void findAzimuthCosSin(double azimuthIndex, double &cosine, double &sine);
+    virtual size_t fillSegments(Step *steps, size_t capacity);
+    virtual bool isSegmentWithinTolerance(long radiusIndex, long azimuthIndex, long radiusSteps, long azimuthSteps);
     virtual void orientPoint(Point &referencePoint, Point &pointToOrient);
     virtual void snapPointToClosestPossiblePosition(Point &point);
     virtual double findDistanceBetweenPoints(Point &first, Point &second);
 
-    virtual bool parseArgumentsAndSetFinish(Point &currentPosition, String &arguments) = 0;
+    virtual bool parseArgumentsAndSetFinish(Point &currentPosition, const Command &command) = 0;
     virtual double findDistanceFromPointOnLineToFinish(Point &point) = 0;
     virtual void setClosestPointOnLine(Point &point, Point &closestPoint) = 0;
     virtual double determineStartingAzimuthFromCenter() = 0;
 
 public:
+    BaseStepper();
     virtual void calibrate(double radiusStepSize, double azimuthStepSize);
-    virtual void startNewLine(Point &currentPosition, String &arguments);
+    virtual void setLookahead(int depth, double maxDeviation);
+    virtual void setSegmentTolerance(double tolerance);
+    virtual void startNewLine(Point &currentPosition, const Command &command);
     virtual bool hasStep();
     virtual Step& step();
+    virtual size_t fillSteps(Step *steps, size_t capacity);
     using AbstractStepper::isFastStep;
 };
 
@@ -23,66 +23,121 @@
 
 #include "circleStepper.h"
 
-bool CircleStepper::parseArgumentsAndSetFinish(Point &currentPosition, String &arguments) {
-    int firstComma = arguments.indexOf(',');
-    int secondComma = arguments.indexOf(',', firstComma + 1);
-    if (secondComma <= 2) return false;
-
-    double centerX = arguments.substring(0, firstComma).toDouble();
-    double centerY = arguments.substring(firstComma + 1, secondComma).toDouble();
-    double thetaDegrees = arguments.substring(secondComma + 1).toDouble();
+bool CircleStepper::parseArgumentsAndSetFinish(Point &currentPosition, const Command &command) {
+    if (command.getArgumentCount() < 3) return false;
+
+    double centerX = command.getArgument(0);
+    double centerY = command.getArgument(1);
+    double thetaDegrees = command.getArgument(2);
     double theta = thetaDegrees / 180 * PI;
     center.cartesianRepoint(centerX, centerY);
     this->orientPoint(currentPosition, center);
 
     radius = this->findDistanceBetweenPoints(currentPosition, center);
+    radiusSquared = radius * radius;
+    inverseDiameter = 1 / (2 * radius);
+    quarterArcLength = radius * (PI / 2);
 
     if (radius < (radiusStepSize * 2) || radius < (azimuthStepSize * 2) || abs(theta) < (azimuthStepSize * 0.1)) return false;
 
     if (abs(theta) > PI) {
         theta = PI * (theta > 0 ? 1 : -1);
     }
+    direction = theta > 0 ? 1 : -1;
 
     double cosTheta = cos(theta);
     double sinTheta = sin(theta);
-    double cosHalfTheta = cos(theta * 0.5);
-    double sinHalfTheta = sin(theta * 0.5);
-    double curX = currentPosition.getX();
-    double curY = currentPosition.getY();
     double cenX = center.getX();
     double cenY = center.getY();
-    double centeredX = curX - cenX;
-    double centeredY = curY - cenY;
-    double middleX = centeredX * cosHalfTheta + centeredY * sinHalfTheta + cenX;
-    double middleY = centeredX * sinHalfTheta + centeredY * cosHalfTheta + cenY;
-    double finishX = centeredX * cosTheta + centeredY * sinTheta + cenX;
+    double centeredX = currentPosition.getX() - cenX;
+    double centeredY = currentPosition.getY() - cenY;
+    double finishX = centeredX * cosTheta - centeredY * sinTheta + cenX;
     double finishY = centeredX * sinTheta + centeredY * cosTheta + cenY;
-    slope = (finishY - curY) / (finishX - curX);
-    intercept = finishY - slope * finishX;
-    double midY = slope * middleX + intercept;
-    middleAboveLine = middleY > midY;
 
     finish.cartesianRepoint(finishX, finishY);
     this->orientPoint(currentPosition, finish);
     this->snapPointToClosestPossiblePosition(finish);
-    slope = (finish.getY() - curY) / (finish.getX() - curX);
-    intercept = finish.getY() - slope * finish.getX();
+    finishCenteredX = finish.getX() - cenX;
+    finishCenteredY = finish.getY() - cenY;
 
     return true;
 }
 
-double CircleStepper::findDistanceFromPointOnLineToFinish(Point &point)
+double CircleStepper::findQuartersToFinish(double centeredX, double centeredY)
+{
+    // A pseudo-angle, in quarter turns from 0 to 4, that grows monotonically with the true angle left to sweep from
+    // the point to the finish.  Unlike the chord length, it changes at full rate at the start of a half circle, and it
+    // jumps to nearly a full turn once the finish has been passed.
+    double dot = centeredX * finishCenteredX + centeredY * finishCenteredY;
+    double cross = (centeredX * finishCenteredY - centeredY * finishCenteredX) * direction;
+    double sum = abs(dot) + abs(cross);
+
+    if (sum <= 0) return 4;
+    return cross < 0 ? 3 + dot / sum : 1 - dot / sum;
+}
+
+bool CircleStepper::chooseNextPosition()
+{
+    double cosines[3], sines[3];
+    CandidateBatch batch;
+    int radiusSteps[HEADING_POINT_COUNT], azimuthSteps[HEADING_POINT_COUNT];
+    double cenX = center.getX();
+    double cenY = center.getY();
+
+    // The tangent at the current position, turned the way the arc goes
+    this->findAzimuthNeighbours(currentAzimuthIndex, cosines, sines);
+    double currentRadius = currentRadiusIndex * radiusStepSize;
+    double currentCenteredX = currentRadius * cosines[1] - cenX;
+    double currentCenteredY = currentRadius * sines[1] - cenY;
+    int count = this->fillHeadingCandidates(currentRadiusIndex, cosines, sines, -currentCenteredY * direction, currentCenteredX * direction,
+                                            batch, radiusSteps, azimuthSteps);
+
+    int closestCandidate = -1;
+    double closestError = 0;
+    for (int i = 0; i < count; i++) {
+        double centeredX = batch.x[i] - cenX;
+        double centeredY = batch.y[i] - cenY;
+        double error = abs(centeredX * centeredX + centeredY * centeredY - radiusSquared);
+        if (closestCandidate < 0 || error < closestError) {
+            closestCandidate = i;
+            closestError = error;
+        }
+    }
+
+    // Past the finish, or with nowhere to go, the full search finds the last steps
+    double distanceToFinish = 0;
+    if (closestCandidate >= 0) {
+        distanceToFinish = this->findQuartersToFinish(batch.x[closestCandidate] - cenX, batch.y[closestCandidate] - cenY) * quarterArcLength;
+    }
+    if (closestCandidate < 0 || distanceToFinish >= currentDistanceToFinish) {
+        return BaseStepper::chooseNextPosition();
+    }
+
+    nextRadiusIndex = currentRadiusIndex + radiusSteps[closestCandidate];
+    nextAzimuthIndex = currentAzimuthIndex + azimuthSteps[closestCandidate];
+    nextDistanceToFinish = distanceToFinish;
+    return true;
+}
+
+void CircleStepper::evaluateCandidates(CandidateBatch &batch, int count)
 {
-    bool aboveLine = point.getY() > (slope * point.getX() + intercept);
-    double distanceToFinish = this->findDistanceBetweenPoints(point, finish);
-    double distanceOnLine = distanceToFinish;
-    
-    if (aboveLine != middleAboveLine) {
-        double distanceToStart = this->findDistanceBetweenPoints(point, start);
-        distanceOnLine += distanceToStart < distanceToFinish ? distanceToStart : distanceToFinish;
+    double cenX = center.getX();
+    double cenY = center.getY();
+
+    for (int i = 0; i < count; i++) {
+        double centeredX = batch.x[i] - cenX;
+        double centeredY = batch.y[i] - cenY;
+        double error = centeredX * centeredX + centeredY * centeredY - radiusSquared;
+
+        batch.distanceToFinish[i] = this->findQuartersToFinish(centeredX, centeredY) * quarterArcLength;
+        batch.deviation[i] = abs(error) * inverseDiameter;
     }
+}
 
-    return distanceOnLine;
+double CircleStepper::findDistanceFromPointOnLineToFinish(Point &point)
+{
+    // Arc length left to travel, in the direction of the arc, with the angle measured as quarter turns
+    return this->findQuartersToFinish(point.getX() - center.getX(), point.getY() - center.getY()) * quarterArcLength;
 }
 
 void CircleStepper::setClosestPointOnLine(Point &point, Point &closestPoint)
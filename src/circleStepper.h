@@ -29,17 +29,29 @@
 class CircleStepper : public BaseStepper
 {
 private:
+    // The arc is rasterized directly on the step lattice.  Candidates are measured by the circle error term
+    // |(x - cx)^2 + (y - cy)^2 - r^2| / 2r, which is the distance from the circle close to it, so every step is a
+    // handful of multiplies with no square roots or trig.  Like the midpoint circle algorithm, each step only weighs
+    // the (up to) three neighbours along the tangent, by the error term alone, and only the one taken is measured
+    // against the finish.
     Point center;
     double radius;
-    double slope;
-    double intercept;
-    bool middleAboveLine;
+    double radiusSquared;
+    double inverseDiameter;
+    double quarterArcLength;
+    double direction;
+    double finishCenteredX;
+    double finishCenteredY;
+
+    double findQuartersToFinish(double centeredX, double centeredY);
 
 protected:
-    bool parseArgumentsAndSetFinish(Point &currentPosition, String &arguments);
+    bool parseArgumentsAndSetFinish(Point &currentPosition, const Command &command);
     double findDistanceFromPointOnLineToFinish(Point &point);
     void setClosestPointOnLine(Point &point, Point &closestPoint);
     double determineStartingAzimuthFromCenter();
+    bool chooseNextPosition();
+    void evaluateCandidates(CandidateBatch &batch, int count);
 };
 
 #endif
@@ -0,0 +1,183 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "command.h"
+
+Command::Command()
+    : code('\0'),
+      argumentCount(0),
+      decimals(0),
+      feedRate(0)
+{
+}
+
+static bool isEnd(const char chr)
+{
+  return chr == '\0' || chr == '\r' || chr == '\n';
+}
+
+static void skipSpaces(const char *&cursor)
+{
+  while (*cursor == ' ' || *cursor == '\t') cursor++;
+}
+
+// Reads an optionally signed decimal number, and any spaces around it, leaving the cursor just after them.  The digits are gathered as one integer
+// and scaled by a power of ten at the end, which rounds the same as the library's own conversion for the lengths of
+// number found in drawings.  Also counts the digits after the decimal point.
+bool Command::parseNumber(const char *&cursor, double &value, int &decimals)
+{
+  skipSpaces(cursor);
+  const char *chr = cursor;
+  bool negative = false;
+  if (*chr == '-' || *chr == '+') negative = *chr++ == '-';
+
+  unsigned long long mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool seenDigit = false;
+  bool seenPoint = false;
+  int places = 0;
+
+  for (;; chr++) {
+    if (*chr >= '0' && *chr <= '9') {
+      seenDigit = true;
+      if (seenPoint) places++;
+      if (mantissa == 0 && *chr == '0') {
+        if (seenPoint) exponent--;
+      } else if (digits < MAX_NUMBER_DIGITS) {
+        mantissa = mantissa * 10 + (*chr - '0');
+        digits++;
+        if (seenPoint) exponent--;
+      } else if (!seenPoint) {
+        exponent++;
+      }
+    } else if (*chr == '.' && !seenPoint) {
+      seenPoint = true;
+    } else {
+      break;
+    }
+  }
+
+  if (!seenDigit) return false;
+
+  double scale = 1;
+  for (int i = exponent < 0 ? -exponent : exponent; i > 0; i--) scale *= 10;
+  value = exponent < 0 ? mantissa / scale : mantissa * scale;
+  if (negative) value = -value;
+  decimals = places;
+
+  cursor = chr;
+  skipSpaces(cursor);
+  return true;
+}
+
+CommandError Command::parse(const char *text)
+{
+  code = '\0';
+  argumentCount = 0;
+  decimals = 0;
+  feedRate = 0;
+
+  if (isEnd(*text)) return COMMAND_EMPTY;
+
+  char chr = *text++;
+  if (chr >= 'a' && chr <= 'z') chr = chr - 'a' + 'A';
+  if ((chr < 'A' || chr > 'Z') && chr != '.') return COMMAND_BAD_CODE;
+
+  // Comma separated numbers, then an optional trailing F{speed}, e.g. L100,100,F50
+  const char *cursor = text;
+  uint8_t count = 0;
+  int mostPlaces = 0;
+  float rate = 0;
+  skipSpaces(cursor);
+  while (!isEnd(*cursor)) {
+    const bool isFeedRate = *cursor == 'F' || *cursor == 'f';
+    double value;
+    int places;
+    if (isFeedRate) cursor++;
+    if (!parseNumber(cursor, value, places)) return COMMAND_BAD_NUMBER;
+    if (places > mostPlaces) mostPlaces = places;
+
+    if (isFeedRate) {
+      rate = value > 0 ? value : 0;
+      if (!isEnd(*cursor)) return COMMAND_BAD_NUMBER;
+      break;
+    }
+
+    if (count >= MAX_COMMAND_ARGUMENTS) return COMMAND_TOO_MANY_ARGUMENTS;
+    arguments[count++] = value;
+
+    // The feed rate may follow the last number with or without a comma
+    if (*cursor == ',') {
+      cursor++;
+      skipSpaces(cursor);
+      if (isEnd(*cursor)) return COMMAND_BAD_NUMBER;
+    } else if (!isEnd(*cursor) && *cursor != 'F' && *cursor != 'f') {
+      return COMMAND_BAD_NUMBER;
+    }
+  }
+
+  code = chr;
+  argumentCount = count;
+  decimals = mostPlaces < MAX_COMMAND_DECIMALS ? mostPlaces : MAX_COMMAND_DECIMALS;
+  feedRate = rate;
+  return COMMAND_OK;
+}
+
+void Command::set(const char code, const double *arguments, const int argumentCount, const double feedRate, const int decimals)
+{
+  this->code = code;
+  this->argumentCount = argumentCount < MAX_COMMAND_ARGUMENTS ? argumentCount : MAX_COMMAND_ARGUMENTS;
+  for (int i = 0; i < this->argumentCount; i++) this->arguments[i] = arguments[i];
+  this->feedRate = feedRate > 0 ? feedRate : 0;
+  this->decimals = decimals < 0 ? 0 : decimals < MAX_COMMAND_DECIMALS ? decimals : MAX_COMMAND_DECIMALS;
+}
+
+const char *Command::describeError(const CommandError error)
+{
+  switch (error) {
+    case COMMAND_OK: return "OK";
+    case COMMAND_EMPTY: return "Empty command";
+    case COMMAND_BAD_CODE: return "Command must start with a letter";
+    case COMMAND_BAD_NUMBER: return "Arguments must be comma separated numbers";
+    case COMMAND_TOO_MANY_ARGUMENTS: return "Too many arguments";
+  }
+
+  return "Unknown error";
+}
+
+String Command::toString() const
+{
+  String text = "";
+  text += code;
+  for (int i = 0; i < argumentCount; i++) {
+    if (i > 0) text += ",";
+    text += String(arguments[i], decimals);
+  }
+  if (feedRate > 0) {
+    text += ",F";
+    text += String(feedRate, decimals);
+  }
+
+  return text;
+}
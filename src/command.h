@@ -0,0 +1,82 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_COMMAND_H_
+#define _POLARPLOTTERCORE_COMMAND_H_
+
+#ifndef __IN_TEST__
+#include <Arduino.h>
+#else
+#include "mockArduino.h"
+#endif
+
+#include <stdint.h>
+
+#define MAX_COMMAND_ARGUMENTS 3
+// Digits past this many are treated as zeros, beyond the precision of an argument anyway
+#define MAX_NUMBER_DIGITS 18
+// A float holds about 7 significant digits, so more decimal places than this are only printed as this many
+#define MAX_COMMAND_DECIMALS 6
+
+enum CommandError : uint8_t {
+  COMMAND_OK,
+  COMMAND_EMPTY,
+  COMMAND_BAD_CODE,
+  COMMAND_BAD_NUMBER,
+  COMMAND_TOO_MANY_ARGUMENTS
+};
+
+// A command parsed once, when it arrives, into its upper-cased code letter and up to MAX_COMMAND_ARGUMENTS numbers, so
+// nothing is parsed (or allocated) while it is drawn.  Parsing reads the comma separated numbers straight out of the
+// text, without copying it.  An optional trailing F{speed} is kept apart as the feed rate.
+// The same code means different things in drawing, manual and calibration modes, so it is left to whoever runs the
+// command to interpret.  Arguments are floats, which keeps a command to 20 bytes, along with the most decimal places
+// any of them was given with, so they print back the way the drawing wrote them.
+class Command
+{
+private:
+  char code;
+  uint8_t argumentCount;
+  uint8_t decimals;
+  float arguments[MAX_COMMAND_ARGUMENTS];
+  float feedRate;
+
+  static bool parseNumber(const char *&cursor, double &value, int &decimals);
+
+public:
+  Command();
+  // On an error the command is left empty, with code '\0'
+  CommandError parse(const char *text);
+  static const char *describeError(const CommandError error);
+  // For commands that arrive already decoded, such as from a binary drawing of the given decimal places
+  void set(const char code, const double *arguments, const int argumentCount, const double feedRate, const int decimals);
+  char getCode() const { return code; }
+  int getArgumentCount() const { return argumentCount; }
+  // Missing arguments read as 0
+  double getArgument(const int index) const { return index < argumentCount ? arguments[index] : 0; }
+  double getFeedRate() const { return feedRate; }
+  int getDecimals() const { return decimals; }
+  String toString() const;
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "commandBuffer.h"
+
+CommandBuffer::CommandBuffer()
+    : head(0),
+      tail(0),
+      count(0)
+{
+}
+
+bool CommandBuffer::add(const Command &command)
+{
+  if (isFull()) return false;
+
+  commands[tail] = command;
+  tail = (tail + 1) % COMMAND_BUFFER_SIZE;
+  count++;
+  return true;
+}
+
+bool CommandBuffer::hasCommand()
+{
+  return count > 0;
+}
+
+bool CommandBuffer::nextCommand(Command &command)
+{
+  if (count == 0) return false;
+
+  command = commands[head];
+  head = (head + 1) % COMMAND_BUFFER_SIZE;
+  count--;
+  return true;
+}
+
+void CommandBuffer::clear()
+{
+  head = 0;
+  tail = 0;
+  count = 0;
+}
@@ -0,0 +1,59 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_COMMANDBUFFER_H_
+#define _POLARPLOTTERCORE_COMMANDBUFFER_H_
+
+#include "commandSource.h"
+
+// How many commands can wait to be drawn
+#ifndef COMMAND_BUFFER_SIZE
+#define COMMAND_BUFFER_SIZE 32
+#endif
+
+// A bounded ring of commands, filled by the controller's addCommand and drained by performCycle.  Commands are kept
+// parsed, in one contiguous array of fixed slots, so there are no heap allocations however long the
+// drawing, and when the ring is full add() refuses the command, so the sender knows to hold off and try again.
+class CommandBuffer : public CommandSource
+{
+private:
+  Command commands[COMMAND_BUFFER_SIZE];
+  int head;
+  int tail;
+  int count;
+
+public:
+  CommandBuffer();
+
+  /** Copies the parsed command into the buffer, returning false without taking it if the buffer is full. */
+  bool add(const Command &command);
+
+  bool isFull() const { return count >= COMMAND_BUFFER_SIZE; }
+  int getCount() const { return count; }
+
+  bool hasCommand();
+  bool nextCommand(Command &command);
+  void clear();
+};
+
+#endif
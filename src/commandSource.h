@@ -0,0 +1,46 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_COMMANDSOURCE_H_
+#define _POLARPLOTTERCORE_COMMANDSOURCE_H_
+
+#include "command.h"
+
+// Where the controller reads drawing commands from, one at a time and in order, so a drawing of any length can stream
+// through without being held in memory all at once.
+class CommandSource
+{
+public:
+  virtual ~CommandSource() {}
+
+  /** Returns true if a command is ready to be read. */
+  virtual bool hasCommand() = 0;
+
+  /** Reads the next command, already parsed, returning false if there was none ready. */
+  virtual bool nextCommand(Command &command) = 0;
+
+  /** Drops any commands not read yet. */
+  virtual void clear() = 0;
+};
+
+#endif
@@ -0,0 +1,242 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "drawingFormat.h"
+#include <math.h>
+
+static const char drawingCodes[] = { '\0', 'L', 'C', 'S', 'W' };
+#define DRAWING_CODE_COUNT 5
+
+static double powerOfTen(const int decimals)
+{
+  double scale = 1;
+  for (int i = 0; i < decimals; i++) scale *= 10;
+  return scale;
+}
+
+DrawingEncoder::DrawingEncoder(const int decimals)
+    : decimals(decimals < 0 ? 0 : decimals > DRAWING_MAX_DECIMALS ? DRAWING_MAX_DECIMALS : decimals),
+      scale(powerOfTen(this->decimals)),
+      error(NULL)
+{
+}
+
+uint8_t DrawingEncoder::toOpcode(const char code)
+{
+  for (uint8_t i = 1; i < DRAWING_CODE_COUNT; i++) {
+    if (drawingCodes[i] == code) return i;
+  }
+
+  return 0;
+}
+
+int DrawingEncoder::writeVarint(uint8_t *buffer, unsigned long value)
+{
+  int length = 0;
+  while (value >= 0x80) {
+    buffer[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  buffer[length++] = (uint8_t)value;
+  return length;
+}
+
+int DrawingEncoder::encodeHeader(uint8_t *buffer, const long maxRadiusSteps, const long fullCircleAzimuthSteps)
+{
+  int length = 0;
+  for (int i = 0; i < DRAWING_MAGIC_LENGTH; i++) buffer[length++] = DRAWING_MAGIC[i];
+  buffer[length++] = DRAWING_VERSION;
+  buffer[length++] = (uint8_t)decimals;
+  length += writeVarint(&buffer[length], maxRadiusSteps > 0 ? maxRadiusSteps : 0);
+  length += writeVarint(&buffer[length], fullCircleAzimuthSteps > 0 ? fullCircleAzimuthSteps : 0);
+
+  for (int i = 0; i <= MAX_COMMAND_ARGUMENTS; i++) previous[i] = 0;
+  return length;
+}
+
+int DrawingEncoder::encodeCommand(uint8_t *buffer, const Command &command)
+{
+  const uint8_t opcode = toOpcode(command.getCode());
+  error = NULL;
+  if (opcode == 0) {
+    error = "Not a drawing command";
+    return 0;
+  }
+
+  const bool hasFeedRate = command.getFeedRate() > 0;
+  const int argumentCount = command.getArgumentCount();
+  const int valueCount = argumentCount + (hasFeedRate ? 1 : 0);
+
+  // Everything is checked before anything is written, so a command that doesn't fit leaves the encoder as it was
+  long fixed[MAX_COMMAND_ARGUMENTS + 1];
+  for (int i = 0; i < valueCount; i++) {
+    const double value = (i < argumentCount ? command.getArgument(i) : command.getFeedRate()) * scale;
+    if (!(fabs(value) <= DRAWING_MAX_FIXED)) {
+      error = "Argument too large for the drawing's decimals";
+      return 0;
+    }
+    fixed[i] = (long)round(value);
+  }
+
+  int length = 0;
+  buffer[length++] = opcode | (argumentCount << DRAWING_ARGUMENT_COUNT_SHIFT) | (hasFeedRate ? DRAWING_FEED_RATE_FLAG : 0);
+
+  for (int i = 0; i < valueCount; i++) {
+    const int slot = i < argumentCount ? i : MAX_COMMAND_ARGUMENTS;
+    const long delta = fixed[i] - previous[slot];
+    previous[slot] = fixed[i];
+
+    // Zigzag, so small negative differences stay small
+    length += writeVarint(&buffer[length], delta < 0 ? ((unsigned long)(-(delta + 1)) << 1) | 1 : (unsigned long)delta << 1);
+  }
+
+  return length;
+}
+
+DrawingDecoder::DrawingDecoder()
+{
+  reset();
+}
+
+void DrawingDecoder::reset()
+{
+  state = DECODING_MAGIC;
+  magicIndex = 0;
+  decimals = 0;
+  scale = 1;
+  maxRadiusSteps = 0;
+  fullCircleAzimuthSteps = 0;
+  varint = 0;
+  varintShift = 0;
+  error = NULL;
+  for (int i = 0; i <= MAX_COMMAND_ARGUMENTS; i++) previous[i] = 0;
+}
+
+char DrawingDecoder::fromOpcode(const uint8_t opcode)
+{
+  const uint8_t code = opcode & DRAWING_CODE_MASK;
+  return code < DRAWING_CODE_COUNT ? drawingCodes[code] : '\0';
+}
+
+bool DrawingDecoder::isVarintTooLong(const uint8_t byte) const
+{
+  // Varints hold at most 32 bits, so a fifth byte only has room for four and is always the last
+  return varintShift >= 28 && (byte & 0xf0) != 0;
+}
+
+bool DrawingDecoder::readVarint(const uint8_t byte)
+{
+  varint |= (unsigned long)(byte & 0x7f) << varintShift;
+  varintShift += 7;
+  return (byte & 0x80) == 0;
+}
+
+DrawingDecodeResult DrawingDecoder::fail(const char *error)
+{
+  this->error = error;
+  state = DECODING_FAILED;
+  return DRAWING_ERROR;
+}
+
+DrawingDecodeResult DrawingDecoder::finishCommand(Command &command)
+{
+  const bool hasFeedRate = (opcode & DRAWING_FEED_RATE_FLAG) != 0;
+  command.set(fromOpcode(opcode), arguments, argumentCount, hasFeedRate ? arguments[argumentCount] : 0, decimals);
+  state = DECODING_OPCODE;
+  return DRAWING_COMMAND;
+}
+
+DrawingDecodeResult DrawingDecoder::decode(const uint8_t byte, Command &command)
+{
+  switch (state) {
+    case DECODING_MAGIC:
+      if (byte != (uint8_t)DRAWING_MAGIC[magicIndex++]) return fail("Not a binary drawing");
+      if (magicIndex == DRAWING_MAGIC_LENGTH) state = DECODING_VERSION;
+      return DRAWING_NEED_MORE;
+
+    case DECODING_VERSION:
+      if (byte != DRAWING_VERSION) return fail("Unsupported drawing version");
+      state = DECODING_DECIMALS;
+      return DRAWING_NEED_MORE;
+
+    case DECODING_DECIMALS:
+      if (byte > DRAWING_MAX_DECIMALS) return fail("Unsupported drawing precision");
+      decimals = byte;
+      scale = powerOfTen(decimals);
+      state = DECODING_RADIUS_STEPS;
+      return DRAWING_NEED_MORE;
+
+    case DECODING_RADIUS_STEPS:
+    case DECODING_AZIMUTH_STEPS:
+      if (isVarintTooLong(byte)) return fail("Malformed drawing header");
+      if (!readVarint(byte)) return DRAWING_NEED_MORE;
+
+      if (state == DECODING_RADIUS_STEPS) {
+        maxRadiusSteps = varint;
+        state = DECODING_AZIMUTH_STEPS;
+        varint = 0;
+        varintShift = 0;
+        return DRAWING_NEED_MORE;
+      }
+
+      fullCircleAzimuthSteps = varint;
+      state = DECODING_OPCODE;
+      return DRAWING_HEADER;
+
+    case DECODING_OPCODE:
+      if (fromOpcode(byte) == '\0') return fail("Unknown drawing command");
+      opcode = byte;
+      argumentCount = (byte & DRAWING_ARGUMENT_COUNT_MASK) >> DRAWING_ARGUMENT_COUNT_SHIFT;
+      if (argumentCount > MAX_COMMAND_ARGUMENTS) return fail("Too many arguments");
+      argumentIndex = 0;
+      varint = 0;
+      varintShift = 0;
+      if (argumentCount == 0 && (byte & DRAWING_FEED_RATE_FLAG) == 0) return finishCommand(command);
+      state = DECODING_ARGUMENTS;
+      return DRAWING_NEED_MORE;
+
+    case DECODING_ARGUMENTS:
+      if (isVarintTooLong(byte)) return fail("Malformed drawing argument");
+      if (!readVarint(byte)) return DRAWING_NEED_MORE;
+
+      {
+        // Undo the zigzag and the difference, then the fixed point
+        const int slot = argumentIndex < argumentCount ? argumentIndex : MAX_COMMAND_ARGUMENTS;
+        const long delta = (varint & 1) ? -(long)(varint >> 1) - 1 : (long)(varint >> 1);
+        // Checked before adding, as the sum of two 32 bit longs could overflow
+        if (delta > DRAWING_MAX_FIXED - previous[slot] || delta < -DRAWING_MAX_FIXED - previous[slot]) return fail("Drawing argument out of range");
+        previous[slot] += delta;
+        arguments[argumentIndex++] = previous[slot] / scale;
+      }
+      varint = 0;
+      varintShift = 0;
+
+      if (argumentIndex < argumentCount + ((opcode & DRAWING_FEED_RATE_FLAG) ? 1 : 0)) return DRAWING_NEED_MORE;
+      return finishCommand(command);
+
+    case DECODING_FAILED:
+      break;
+  }
+
+  return DRAWING_NEED_MORE;
+}
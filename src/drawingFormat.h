@@ -0,0 +1,147 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_DRAWINGFORMAT_H_
+#define _POLARPLOTTERCORE_DRAWINGFORMAT_H_
+
+#include "command.h"
+
+// A binary drawing starts with a header: the magic bytes "PPD", the format version, how many decimal places the
+// arguments keep, then the table calibration it was made for (maximum radius steps and full circle azimuth steps, as
+// varints, 0 if unknown).  Each command follows as one opcode byte, with the drawing command in the low nibble, the
+// argument count in the next two bits and DRAWING_FEED_RATE_FLAG set if a feed rate follows the arguments.  Arguments
+// and feed rates are fixed point, with the header's decimal places, each stored as the difference from the same
+// argument of the command before (or the feed rate before), zigzag encoded as an LEB128 varint.  Neighbouring points of
+// a drawing are close together, so most arguments take a byte or two whatever their sign or size.
+#define DRAWING_MAGIC "PPD"
+#define DRAWING_MAGIC_LENGTH 3
+#define DRAWING_VERSION 1
+#define DRAWING_DEFAULT_DECIMALS 2
+#define DRAWING_MAX_DECIMALS 6
+// The largest fixed point argument, so the zigzag of the difference between two of them still fits a 32 bit varint.
+// At 6 decimals that is arguments up to about 1073.
+#define DRAWING_MAX_FIXED 0x3fffffffL
+#define DRAWING_MAX_HEADER_LENGTH 15
+// An opcode and its arguments, at up to 5 bytes a varint
+#define DRAWING_MAX_COMMAND_LENGTH (1 + 5 * (MAX_COMMAND_ARGUMENTS + 1))
+#define DRAWING_CODE_MASK 0x0f
+#define DRAWING_ARGUMENT_COUNT_SHIFT 4
+#define DRAWING_ARGUMENT_COUNT_MASK 0x30
+#define DRAWING_FEED_RATE_FLAG 0x80
+
+enum DrawingDecodeResult {
+  DRAWING_NEED_MORE,
+  DRAWING_HEADER,
+  DRAWING_COMMAND,
+  DRAWING_ERROR
+};
+
+enum DrawingDecodeState {
+  DECODING_MAGIC,
+  DECODING_VERSION,
+  DECODING_DECIMALS,
+  DECODING_RADIUS_STEPS,
+  DECODING_AZIMUTH_STEPS,
+  DECODING_OPCODE,
+  DECODING_ARGUMENTS,
+  DECODING_FAILED
+};
+
+// Writes binary drawings, a header then one command at a time, into caller supplied buffers
+class DrawingEncoder
+{
+private:
+  int decimals;
+  double scale;
+  long previous[MAX_COMMAND_ARGUMENTS + 1];
+  const char *error;
+
+  static int writeVarint(uint8_t *buffer, unsigned long value);
+
+public:
+  DrawingEncoder(const int decimals = DRAWING_DEFAULT_DECIMALS);
+
+  /** Writes the header, of at most DRAWING_MAX_HEADER_LENGTH bytes, returning its length. */
+  int encodeHeader(uint8_t *buffer, const long maxRadiusSteps, const long fullCircleAzimuthSteps);
+
+  /**
+   * Writes the command, of at most DRAWING_MAX_COMMAND_LENGTH bytes, returning its length, or 0 if it isn't a drawing
+   * command (L, C, S or W) or an argument is too large for the decimal places, with getError() saying which.
+   */
+  int encodeCommand(uint8_t *buffer, const Command &command);
+
+  /** Returns why the last command wasn't written, or NULL if it was. */
+  const char *getError() const { return error; }
+
+  static uint8_t toOpcode(const char code);
+};
+
+// Reads a binary drawing a byte at a time, so it can be fed straight from a serial port or file in whatever chunks
+// arrive.  Nothing is parsed from text, each argument is a varint and a multiply.
+class DrawingDecoder
+{
+private:
+  DrawingDecodeState state;
+  int magicIndex;
+  int decimals;
+  double scale;
+  long maxRadiusSteps;
+  long fullCircleAzimuthSteps;
+
+  uint8_t opcode;
+  int argumentCount;
+  int argumentIndex;
+  double arguments[MAX_COMMAND_ARGUMENTS + 1];
+
+  long previous[MAX_COMMAND_ARGUMENTS + 1];
+
+  unsigned long varint;
+  int varintShift;
+  const char *error;
+
+  bool isVarintTooLong(const uint8_t byte) const;
+  bool readVarint(const uint8_t byte);
+  DrawingDecodeResult fail(const char *error);
+  DrawingDecodeResult finishCommand(Command &command);
+
+public:
+  DrawingDecoder();
+
+  /** Starts again, expecting a header. */
+  void reset();
+
+  /**
+   * Takes the next byte of the drawing, returning DRAWING_COMMAND once a whole command has been read into the given
+   * command, DRAWING_HEADER once the header has been read, and DRAWING_ERROR (once) if the drawing is malformed, after
+   * which the rest of it is ignored until reset().
+   */
+  DrawingDecodeResult decode(const uint8_t byte, Command &command);
+
+  long getMaxRadiusSteps() const { return maxRadiusSteps; }
+  long getFullCircleAzimuthSteps() const { return fullCircleAzimuthSteps; }
+  const char *getError() const { return error; }
+
+  static char fromOpcode(const uint8_t opcode);
+};
+
+#endif
@@ -23,12 +23,52 @@
 
 #include "lineStepper.h"
 
-bool LineStepper::parseArgumentsAndSetFinish(Point &currentPosition, String &arguments) {
-    int comma = arguments.indexOf(',');
-    if (comma <= 0) return false;
+bool LineStepper::chooseNextPosition()
+{
+    double cosines[3], sines[3];
+    CandidateBatch batch;
+    int radiusSteps[HEADING_POINT_COUNT], azimuthSteps[HEADING_POINT_COUNT];
+
+    this->findAzimuthNeighbours(currentAzimuthIndex, cosines, sines);
+    int count = this->fillHeadingCandidates(currentRadiusIndex, cosines, sines, alongX, alongY, batch, radiusSteps, azimuthSteps);
+    this->evaluateCandidates(batch, count);
+
+    // Of the neighbours that get closer to the finish, take the one closest to the line
+    int closestCandidate = -1;
+    for (int i = 0; i < count; i++) {
+        if (batch.distanceToFinish[i] >= currentDistanceToFinish) continue;
+        if (closestCandidate < 0 || batch.deviation[i] < batch.deviation[closestCandidate]) {
+            closestCandidate = i;
+        }
+    }
+
+    // None of them does close to the finish, where the full search can still find the last steps
+    if (closestCandidate < 0) {
+        return BaseStepper::chooseNextPosition();
+    }
+
+    nextRadiusIndex = currentRadiusIndex + radiusSteps[closestCandidate];
+    nextAzimuthIndex = currentAzimuthIndex + azimuthSteps[closestCandidate];
+    nextDistanceToFinish = batch.distanceToFinish[closestCandidate];
+    return true;
+}
 
-    double finishX = arguments.substring(0, comma).toDouble();
-    double finishY = arguments.substring(comma + 1).toDouble();
+void LineStepper::evaluateCandidates(CandidateBatch &batch, int count)
+{
+    for (int i = 0; i < count; i++) {
+        double along = batch.x[i] * alongX + batch.y[i] * alongY;
+        double across = batch.y[i] * alongX - batch.x[i] * alongY;
+
+        batch.distanceToFinish[i] = abs(finishAlong - along);
+        batch.deviation[i] = abs(across - lineOffset);
+    }
+}
+
+bool LineStepper::parseArgumentsAndSetFinish(Point &currentPosition, const Command &command) {
+    if (command.getArgumentCount() < 2) return false;
+
+    double finishX = command.getArgument(0);
+    double finishY = command.getArgument(1);
     deltaX = finishX - currentPosition.getX();
     deltaY = finishY - currentPosition.getY();
 
@@ -36,12 +76,19 @@ bool LineStepper::parseArgumentsAndSetFinish(Point &currentPosition, String &arg
     this->orientPoint(currentPosition, finish);
     this->snapPointToClosestPossiblePosition(finish);
 
+    double length = sqrt(deltaX * deltaX + deltaY * deltaY);
+    alongX = length > 0 ? deltaX / length : 0;
+    alongY = length > 0 ? deltaY / length : 0;
+    lineOffset = currentPosition.getY() * alongX - currentPosition.getX() * alongY;
+    finishAlong = finish.getX() * alongX + finish.getY() * alongY;
+
     return true;
 }
 
 double LineStepper::findDistanceFromPointOnLineToFinish(Point &point)
 {
-    return findDistanceBetweenPoints(point, this->finish);
+    // Measured along the line, so that it matches the distances used by the rasterizer
+    return abs(finishAlong - (point.getX() * alongX + point.getY() * alongY));
 }
 
 void LineStepper::setClosestPointOnLine(Point &point, Point &closestPoint)
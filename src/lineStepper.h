@@ -32,11 +32,22 @@ private:
     double deltaX;
     double deltaY;
 
+    // The line is rasterized directly on the step lattice.  Candidate positions are measured in the frame of the
+    // line: "along" is the distance travelled in the direction of the line, and "across" is the signed distance from
+    // the line.  Both are two multiplies and an add per candidate, with no Points or square roots.  Each step only
+    // weighs the (up to) three neighbours in the direction of the line, like a Bresenham line on the polar lattice.
+    double alongX;
+    double alongY;
+    double lineOffset;
+    double finishAlong;
+
 protected:
-    bool parseArgumentsAndSetFinish(Point &currentPosition, String &arguments);
+    bool parseArgumentsAndSetFinish(Point &currentPosition, const Command &command);
     double findDistanceFromPointOnLineToFinish(Point &point);
     void setClosestPointOnLine(Point &point, Point &closestPoint);
     double determineStartingAzimuthFromCenter();
+    bool chooseNextPosition();
+    void evaluateCandidates(CandidateBatch &batch, int count);
 };
 
 #endif
@@ -0,0 +1,42 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_PICOSTEPPINS_H_
+#define _POLARPLOTTERCORE_PICOSTEPPINS_H_
+
+#if defined(ARDUINO_ARCH_RP2040) && !defined(__IN_TEST__)
+#include <Arduino.h>
+#include "hardware/gpio.h"
+#include "stepPins.h"
+
+// StepPins on the RP2040's single-cycle IO block, whose set and clear registers change any number of GPIOs in one
+// store.  The pins still have to be set up as outputs, which the motors' init() does.
+class PicoStepPins : public StepPins
+{
+public:
+    void set(const unsigned long mask);
+    void clear(const unsigned long mask);
+};
+
+#endif
+#endif
@@ -0,0 +1,75 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "picoStepTimer.h"
+
+#if defined(ARDUINO_ARCH_RP2040) && !defined(__IN_TEST__)
+
+PicoStepTimer *PicoStepTimer::alarmOwners[PICO_ALARM_COUNT] = { NULL, NULL, NULL, NULL };
+
+PicoStepTimer::PicoStepTimer()
+    : alarm(-1),
+      callback(NULL),
+      context(NULL)
+{
+}
+
+void PicoStepTimer::begin()
+{
+    alarm = hardware_alarm_claim_unused(true);
+    alarmOwners[alarm] = this;
+    hardware_alarm_set_callback(alarm, &PicoStepTimer::onAlarm);
+}
+
+unsigned long PicoStepTimer::now()
+{
+    return (unsigned long)time_us_64();
+}
+
+void PicoStepTimer::schedule(const unsigned long atMicros, Callback callback, void *context)
+{
+    this->callback = callback;
+    this->context = context;
+
+    // Widen the 32 bit time to the 64 bit timer, allowing for it having wrapped
+    uint64_t current = time_us_64();
+    long offset = (long)(atMicros - (unsigned long)current);
+    uint64_t target = offset > 0 ? current + offset : current;
+
+    if (hardware_alarm_set_target(alarm, from_us_since_boot(target)))
+        hardware_alarm_force_irq(alarm);
+}
+
+void PicoStepTimer::cancel()
+{
+    hardware_alarm_cancel(alarm);
+}
+
+void PicoStepTimer::onAlarm(uint alarmNumber)
+{
+    PicoStepTimer *owner = alarmOwners[alarmNumber];
+    if (owner != NULL && owner->callback != NULL)
+        owner->callback(owner->context);
+}
+
+#endif
@@ -30,7 +30,12 @@ PlotterController::PlotterController(Print &printer, StatusUpdate &statusUpdater
       state(INITIALIZING),
       lastState(INITIALIZING),
       lastTextState("Initializing"),
-      coordinator(coordinator)
+      coordinator(coordinator),
+      commandSource(&commandBuffer),
+      commandCount(0),
+      commandIndex(0),
+      calibrationRadiusSteps(0),
+      calibrationAzimuthSteps(0)
 {
 }
 
@@ -48,6 +53,16 @@ void PlotterController::calibrate(double radiusStepSize, double azimuthStepSize)
   plotter.calibrate(0.0, 0.0, radiusStepSize, azimuthStepSize);
 }
 
+void PlotterController::setLookahead(int depth, double maxDeviation)
+{
+  plotter.setLookahead(depth, maxDeviation);
+}
+
+void PlotterController::setSegmentTolerance(double tolerance)
+{
+  plotter.setSegmentTolerance(tolerance);
+}
+
 void PlotterController::onRecalibrate(void recalibrater(const int maxRadiusSteps, const int fullCircleAzimuthSteps))
 {
   this->recalibrater = recalibrater;
@@ -61,10 +76,16 @@ void PlotterController::performCycle()
 
   const bool calibrating = isCalibrating();
   const bool manual = isManual();
+  // Manual and calibration moves wait in the buffer until the plotter has room for them
+  if ((calibrating || manual) && !plotter.canMove()) {
+    return;
+  }
+
   if (calibrating || manual || !plotter.hasNextStep())
   {
     if (this->needsCommands()) {
-      String defaultCommand = ".";
+      Command defaultCommand;
+      defaultCommand.parse(".");
 
       if (calibrating) {
         this->handleCalibrationCommand(defaultCommand);
@@ -81,9 +102,11 @@ void PlotterController::performCycle()
 
       return;
     } else {
-      String command = commands[commandIndex++];
+      Command command;
+      commandSource->nextCommand(command);
+      commandIndex++;
       String str = "";
-      statusUpdater.status(drawing, str + (commandIndex) + ": " + command);
+      statusUpdater.status(drawing, str + (commandIndex) + ": " + command.toString());
 
       this->executeCommand(command);
     }
@@ -101,7 +124,7 @@ void PlotterController::performCycle()
   }
 }
 
-void PlotterController::executeCommand(String& command) {
+void PlotterController::executeCommand(Command& command) {
   if (isManual()) {
     handleManualCommand(command);
     return;
@@ -114,7 +137,7 @@ void PlotterController::executeCommand(String& command) {
   printer.print("Starting command ");
   printer.print(commandIndex);
   printer.print(": ");
-  printer.println(command);
+  printer.println(command.toString());
   plotter.startCommand(command);
   printer.print("    Has Steps: ");
   printer.println(plotter.hasNextStep());
@@ -129,8 +152,7 @@ void PlotterController::handleControlCommand(String& command) {
       printer.println("Starting calibration");
       statusUpdater.setState("Calibrating Center");
 
-      commandIndex = 0;
-      commandCount = 0;
+      clearCommands();
       lastState = state;
       state = CALIBRATING_ORIGIN;
       break;
@@ -171,6 +193,9 @@ void PlotterController::handleControlCommand(String& command) {
 
         stp = coordinator->getCurrentStep();
         msg += ",\"Stp\":{\"R\":"; msg += stp.getRadiusStep(); msg += ",\"A\":"; msg += stp.getAzimuthStep(); msg += ",\"F\":"; msg += stp.isFast(); msg += "}";
+
+        msg += ",\"Queue\":{\"Cap\":"; msg += coordinator->getQueueCapacity(); msg += ",\"Max\":"; msg += coordinator->getQueueHighWaterMark();
+        msg += ",\"Under\":"; msg += coordinator->getQueueUnderruns(); msg += ",\"Gap\":"; msg += coordinator->getTimelineGapMicros(); msg += "}";
       }
 
       msg += ",\"State\":"; msg += state;
@@ -178,6 +203,7 @@ void PlotterController::handleControlCommand(String& command) {
       msg += "\",\"Drawing\":\""; msg += drawing;
       msg += "\",\"CommandCount\":"; msg += commandCount;
       msg += ",\"CommandIndex\":"; msg += commandIndex;
+      msg += ",\"Buffered\":"; msg += commandBuffer.getCount();
       msg += ",\"CalibrationRadiusSteps\":"; msg += calibrationRadiusSteps;
       msg += ",\"CalibrationAzimuthSteps\":"; msg += calibrationAzimuthSteps;
       msg += "}";
@@ -188,22 +214,24 @@ void PlotterController::handleControlCommand(String& command) {
       printer.println(PolarPlotter::getHelpMessage());
       break;
     case 'W': case 'w':
-      commandIndex = 0;
-      commandCount = 0;
-      String cmd = "W";
-      plotter.startCommand(cmd);
+      clearCommands();
+      Command wipe;
+      wipe.parse("W");
+      plotter.startCommand(wipe);
       break;
   }
 }
 
-void PlotterController::handleCalibrationCommand(String& command) {
-  const char chr = command.charAt(0);
+void PlotterController::handleCalibrationCommand(Command& command) {
+  const char chr = command.getCode();
   long radiusSteps = 0;
   long azimuthSteps = 0;
+  bool countRadius = false;
+  bool countAzimuth = false;
 
   if (chr != '.') {
     printer.print("Got calibration command:");
-    printer.println(command);
+    printer.println(command.toString());
   }
 
   switch (state) {
@@ -212,12 +240,9 @@ void PlotterController::handleCalibrationCommand(String& command) {
       switch (chr)
       {
         case 'E':
-        case 'e':
           if (state == CALIBRATING_ORIGIN) {
-            String manualCalibration = command.substring(1);
-            int commaPosition = manualCalibration.indexOf(',');
-            calibrationRadiusSteps = manualCalibration.substring(0, commaPosition).toInt();
-            calibrationAzimuthSteps = manualCalibration.substring(commaPosition + 1).toInt();
+            calibrationRadiusSteps = (long)round(command.getArgument(0));
+            calibrationAzimuthSteps = (long)round(command.getArgument(1));
             printer.print("Using explicit calibration, calibrationRadiusSteps=");
             printer.print(calibrationRadiusSteps);
             printer.print(", calibrationAzimuthSteps=");
@@ -227,7 +252,6 @@ void PlotterController::handleCalibrationCommand(String& command) {
           }
           break;
         case 'A': // Accept
-        case 'a':
           if (state == CALIBRATING_ORIGIN) {
             printer.println("Finished origin calibration, switching to radius calibration");
             statusUpdater.setState("Calibrating Edge");
@@ -241,29 +265,26 @@ void PlotterController::handleCalibrationCommand(String& command) {
           }
           break;
         case 'O': // Offset
-        case 'o':
-          radiusSteps = command.substring(1).toInt();
+          radiusSteps = (long)round(command.getArgument(0));
           break;
         default: azimuthSteps = state == CALIBRATING_ORIGIN ? 1 : 0; break;
       }
 
-      if (state == CALIBRATING_RADIUS) calibrationRadiusSteps += radiusSteps;
+      countRadius = state == CALIBRATING_RADIUS;
     break;
     case CALIBRATING_AZIMUTH:
       switch (chr)
       {
         case 'A': // Accept
-        case 'a':
           printer.println("Waiting for calibration moves to finish");
           state = FINISHING_CALIBRATION;
           radiusSteps = -1 * calibrationRadiusSteps;
           break;
         case 'O': // Offset
-        case 'o':
-          azimuthSteps = command.substring(1).toInt();
+          azimuthSteps = (long)round(command.getArgument(0));
           break;
       }
-      calibrationAzimuthSteps += azimuthSteps;
+      countAzimuth = true;
     break;
     case FINISHING_CALIBRATION:
       if (coordinator && !coordinator->isMoving()) {
@@ -282,20 +303,24 @@ void PlotterController::handleCalibrationCommand(String& command) {
     return;
   }
 
-  manualStep(radiusSteps, azimuthSteps, chr != '.');
+  // Only steps the plotter took count towards the calibration
+  if (manualStep(radiusSteps, azimuthSteps, chr != '.')) {
+    if (countRadius) calibrationRadiusSteps += radiusSteps;
+    if (countAzimuth) calibrationAzimuthSteps += azimuthSteps;
+  }
 }
 
 bool PlotterController::isCalibrating() {
   return state == CALIBRATING_ORIGIN || state == CALIBRATING_RADIUS || state == CALIBRATING_AZIMUTH || state == FINISHING_CALIBRATION;
 }
 
-void PlotterController::handleManualCommand(String& command) {
+void PlotterController::handleManualCommand(Command& command) {
   if (!isManual()) return;
 
-  const char chr = command.charAt(0);
+  const char chr = command.getCode();
   if (chr != '.') {
     printer.print("Got manual command:");
-    printer.println(command);
+    printer.println(command.toString());
   }
 
   long radiusSteps = 0;
@@ -304,7 +329,6 @@ void PlotterController::handleManualCommand(String& command) {
   switch (chr)
   {
     case 'A': // Manual Azimuth
-    case 'a':
       if (state != MANUAL_AZIMUTH) {
         printer.println("Switching to manual azimuth");
         statusUpdater.setState("Manual Azimuth");
@@ -312,7 +336,6 @@ void PlotterController::handleManualCommand(String& command) {
       }
       break;
     case 'R': // Manual Radius
-    case 'r':
       if (state != MANUAL_RADIUS) {
         printer.println("Switching to manual radius");
         statusUpdater.setState("Manual Radius");
@@ -320,7 +343,6 @@ void PlotterController::handleManualCommand(String& command) {
       }
       break;
     case 'C': // Manual Center
-    case 'c':
       if (isCalibrated) {
         radiusSteps = -1 * round(plotter.getPosition().getRadius() / radiusStepSize);
         printer.print("Manualling moving to center, steps=");
@@ -328,7 +350,6 @@ void PlotterController::handleManualCommand(String& command) {
       }
       break;
     case 'X': // Exit
-    case 'x':
       if (isCalibrated) {
         printer.println("Resuming drawing from manual mode");
         statusUpdater.setState(lastTextState);
@@ -340,11 +361,10 @@ void PlotterController::handleManualCommand(String& command) {
       }
       break;
     case 'O': // Offset
-    case 'o':
       if (state == MANUAL_AZIMUTH) {
-        azimuthSteps = command.substring(1).toInt();
+        azimuthSteps = (long)round(command.getArgument(0));
       } else if (state == MANUAL_RADIUS) {
-        radiusSteps = command.substring(1).toInt();
+        radiusSteps = (long)round(command.getArgument(0));
       }
       break;
     default: break;
@@ -353,8 +373,8 @@ void PlotterController::handleManualCommand(String& command) {
   manualStep(radiusSteps, azimuthSteps, chr != '.');
 }
 
-void PlotterController::manualStep(const long radiusSteps, const long azimuthSteps, const bool printStep) {
-  if (radiusSteps == 0 && azimuthSteps == 0) return;
+bool PlotterController::manualStep(const long radiusSteps, const long azimuthSteps, const bool printStep) {
+  if (radiusSteps == 0 && azimuthSteps == 0) return true;
 
   if (printStep) {
     printer.print("Manual stepping, radiusSteps=");
@@ -363,7 +383,10 @@ void PlotterController::manualStep(const long radiusSteps, const long azimuthSte
     printer.println(azimuthSteps);
   }
 
-  plotter.moveTo(radiusSteps, azimuthSteps, true);
+  if (plotter.moveTo(radiusSteps, azimuthSteps, true)) return true;
+
+  if (printStep) printer.println("Manual step refused, the step queue is full");
+  return false;
 }
 
 bool PlotterController::isManual() {
@@ -377,27 +400,87 @@ bool PlotterController::canCycle()
 
 bool PlotterController::needsCommands()
 {
-  return commandIndex >= commandCount;
+  return !commandSource->hasCommand();
 }
 
-void PlotterController::newDrawing(String &drawing)
+void PlotterController::clearCommands()
 {
+  commandSource->clear();
   commandIndex = 0;
   commandCount = 0;
+}
+
+void PlotterController::setCommandSource(CommandSource *source)
+{
+  commandSource = source ? source : &commandBuffer;
+}
+
+void PlotterController::newDrawing(String &drawing)
+{
+  // Whatever was left of the last drawing must not be drawn at the start of this one
+  clearCommands();
+  drawingDecoder.reset();
   this->drawing = drawing;
+  if (coordinator) coordinator->resetQueueStats();
   const String drawingArg = drawing;
   statusUpdater.setCurrentDrawing(drawingArg);
 }
 
-void PlotterController::addCommand(String &command)
+bool PlotterController::addCommand(String &command)
 {
   if (command.charAt(0) == '.') {
     handleControlCommand(command);
-    return;
+    return true;
   }
 
-  if (commandCount < MAX_COMMAND_COUNT)
-  {
-    commands[commandCount++] = command;
+  // A full buffer is the sender's cue to hold on to the command and offer it again once some have been drawn
+  if (commandBuffer.isFull()) {
+    return false;
+  }
+
+  Command parsed;
+  CommandError error = parsed.parse(command.c_str());
+  if (error != COMMAND_OK) {
+    printer.print("Skipping command, ");
+    printer.print(Command::describeError(error));
+    printer.print(": ");
+    printer.println(command);
+    return true;
   }
+
+  commandBuffer.add(parsed);
+  commandCount++;
+  return true;
+}
+
+int PlotterController::addDrawingBytes(const uint8_t *bytes, const int length)
+{
+  int taken = 0;
+  Command command;
+
+  while (taken < length && !commandBuffer.isFull()) {
+    switch (drawingDecoder.decode(bytes[taken++], command)) {
+      case DRAWING_COMMAND:
+        commandBuffer.add(command);
+        commandCount++;
+        break;
+      case DRAWING_HEADER:
+        if (calibrationRadiusSteps > 0 && drawingDecoder.getMaxRadiusSteps() > 0 &&
+            (drawingDecoder.getMaxRadiusSteps() != calibrationRadiusSteps || drawingDecoder.getFullCircleAzimuthSteps() != calibrationAzimuthSteps)) {
+          printer.print("Drawing was made for a different calibration, radiusSteps=");
+          printer.print(drawingDecoder.getMaxRadiusSteps());
+          printer.print(", azimuthSteps=");
+          printer.println(drawingDecoder.getFullCircleAzimuthSteps());
+        }
+        break;
+      case DRAWING_ERROR:
+        printer.print("Skipping the rest of the drawing, ");
+        printer.println(drawingDecoder.getError());
+        break;
+      case DRAWING_NEED_MORE:
+        break;
+    }
+  }
+
+  return taken;
 }
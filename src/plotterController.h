@@ -24,8 +24,9 @@
 #ifndef _POLARPLOTTERCORE_PLOTTERCONTROLLER_H_
 #define _POLARPLOTTERCORE_PLOTTERCONTROLLER_H_
 
-#define MAX_COMMAND_COUNT 1024
 #include "polarPlotter.h"
+#include "commandBuffer.h"
+#include "drawingFormat.h"
 
 #define TOPIC_SUBSCRIPTION_COUNT 3
 
@@ -52,9 +53,11 @@ private:
   PolarPlotter plotter;
   void (*recalibrater)(const int maxRadiusSteps, const int fullCircleAzimuthSteps);
   String drawing;
-  String commands[MAX_COMMAND_COUNT];
-  int commandCount;
-  int commandIndex;
+  CommandBuffer commandBuffer;
+  CommandSource *commandSource;
+  DrawingDecoder drawingDecoder;
+  long commandCount;
+  long commandIndex;
   int calibrationRadiusSteps;
   int calibrationAzimuthSteps;
   double radiusStepSize;
@@ -64,22 +67,32 @@ private:
   String lastTextState;
 
   bool needsCommands();
+  void clearCommands();
   bool isCalibrating();
   bool isManual();
-  void manualStep(const long radiusSteps, const long azimuthSteps, const bool printStep);
-  void executeCommand(String& command);
+  bool manualStep(const long radiusSteps, const long azimuthSteps, const bool printStep);
+  void executeCommand(Command& command);
   void handleControlCommand(String& command);
-  void handleCalibrationCommand(String& command);
-  void handleManualCommand(String& command);
+  void handleCalibrationCommand(Command& command);
+  void handleManualCommand(Command& command);
 
 public:
   PlotterController(Print &printer, StatusUpdate &statusUpdater, double maxRadius, int marbleSizeInRadiusSteps, PolarMotorCoordinator* coordinator);
   void calibrate(double radiusStepSize, double azimuthStepSize);
+  void setLookahead(int depth, double maxDeviation);
+  void setSegmentTolerance(double tolerance);
   void onRecalibrate(void recalibrater(const int maxRadiusSteps, const int fullCircleAzimuthSteps));
   void performCycle();
   bool canCycle();
   void newDrawing(String &drawing);
-  void addCommand(String &command);
+  // Returns false, without taking the command, while the command buffer is full
+  bool addCommand(String &command);
+  bool canAddCommand() const { return !commandBuffer.isFull(); }
+  // Takes the next part of a binary drawing (see drawingFormat.h), started by newDrawing, returning how many bytes were
+  // used, which is fewer than length while the command buffer is full
+  int addDrawingBytes(const uint8_t *bytes, const int length);
+  // Draws from another source, such as a file, instead of the command buffer, until set back to NULL
+  void setCommandSource(CommandSource *source);
   bool isPaused() const { return state == PAUSED; }
 };
 
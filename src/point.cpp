@@ -23,12 +23,18 @@
 
 #include "point.h"
 
+#ifdef __IN_TEST__
+unsigned long Point::cartesianConversions = 0;
+unsigned long Point::polarConversions = 0;
+#endif
+
 Point::Point()
 {
   this->x = 0;
   this->y = 0;
   this->radius = 0;
   this->azimuth = 0;
+  this->valid = POINT_CARTESIAN_VALID | POINT_POLAR_VALID;
 }
 
 Point::Point(double radius, double azimuth)
@@ -42,48 +48,91 @@ Point::Point(double x, double y, double radius, double azimuth)
   this->y = y;
   this->radius = radius;
   this->azimuth = azimuth;
+  this->valid = POINT_CARTESIAN_VALID | POINT_POLAR_VALID;
 }
 
 double Point::getX() const
 {
+  if (!(this->valid & POINT_CARTESIAN_VALID)) this->computeCartesian();
   return this->x;
 }
 
 double Point::getY() const
 {
+  if (!(this->valid & POINT_CARTESIAN_VALID)) this->computeCartesian();
   return this->y;
 }
 
 double Point::getRadius() const
 {
+  if (!(this->valid & POINT_POLAR_VALID)) this->computePolar();
   return this->radius;
 }
 
 double Point::getAzimuth() const
 {
+  if (!(this->valid & POINT_POLAR_VALID)) this->computePolar();
   return this->azimuth;
 }
 
+bool Point::hasCartesian() const
+{
+  return this->valid & POINT_CARTESIAN_VALID;
+}
+
+bool Point::hasPolar() const
+{
+  return this->valid & POINT_POLAR_VALID;
+}
+
 void Point::repoint(double radius, double azimuth)
 {
-  this->x = radius * cos(azimuth);
-  this->y = radius * sin(azimuth);
   this->radius = radius;
   this->azimuth = azimuth;
+  this->valid = POINT_POLAR_VALID;
+}
+
+void Point::repoint(double radius, double azimuth, double cosAzimuth, double sinAzimuth)
+{
+  this->x = radius * cosAzimuth;
+  this->y = radius * sinAzimuth;
+  this->radius = radius;
+  this->azimuth = azimuth;
+  this->valid = POINT_CARTESIAN_VALID | POINT_POLAR_VALID;
 }
 
 void Point::cartesianRepoint(double x, double y)
 {
   this->x = x;
   this->y = y;
-  this->radius = sqrt(x * x + y * y);
-  this->azimuth = atan2(y, x);
+  this->valid = POINT_CARTESIAN_VALID;
 }
 
-void Point::cloneFrom(Point &other)
+void Point::cloneFrom(const Point &other)
 {
   this->x = other.x;
   this->y = other.y;
   this->radius = other.radius;
   this->azimuth = other.azimuth;
-}
\ No newline at end of file
+  this->valid = other.valid;
+}
+
+void Point::computeCartesian() const
+{
+#ifdef __IN_TEST__
+  cartesianConversions++;
+#endif
+  this->x = this->radius * cos(this->azimuth);
+  this->y = this->radius * sin(this->azimuth);
+  this->valid |= POINT_CARTESIAN_VALID;
+}
+
+void Point::computePolar() const
+{
+#ifdef __IN_TEST__
+  polarConversions++;
+#endif
+  this->radius = sqrt(this->x * this->x + this->y * this->y);
+  this->azimuth = atan2(this->y, this->x);
+  this->valid |= POINT_POLAR_VALID;
+}
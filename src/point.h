@@ -26,15 +26,30 @@
 
 #include "math.h"
 
+#define POINT_CARTESIAN_VALID 0x01
+#define POINT_POLAR_VALID 0x02
+
+// A point keeps whichever representation it was last given, and only converts to the other one the first time
+// that representation is read.  Callers that only ever read one side (e.g. radius/azimuth while stepping) never
+// pay for the trig of the other.
 class Point
 {
 private:
-  double x;
-  double y;
-  double radius;
-  double azimuth;
+  mutable double x;
+  mutable double y;
+  mutable double radius;
+  mutable double azimuth;
+  mutable unsigned char valid;
+
+  void computeCartesian() const;
+  void computePolar() const;
 
 public:
+#ifdef __IN_TEST__
+  static unsigned long cartesianConversions;
+  static unsigned long polarConversions;
+#endif
+
   Point();
   Point(double radius, double azimuth);
   Point(double x, double y, double radius, double azimuth);
@@ -43,8 +58,11 @@ public:
   double getRadius() const;
   double getAzimuth() const;
   void repoint(double radius, double azimuth);
+  void repoint(double radius, double azimuth, double cosAzimuth, double sinAzimuth);
   void cartesianRepoint(double x, double y);
-  void cloneFrom(Point &other);
+  void cloneFrom(const Point &other);
+  bool hasCartesian() const;
+  bool hasPolar() const;
 };
 
 #endif
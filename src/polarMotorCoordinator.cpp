@@ -32,8 +32,21 @@ PolarMotorCoordinator::PolarMotorCoordinator(StepDirMotor *_radius, StepDirMotor
       minimumInterval(_minimumInterval),
       maximumInterval(_maximumInterval),
       currentInterval(_minimumInterval),
-      slowSpeedIntervalMultiplier(_slowSpeedIntervalMultiplier)
+      slowSpeedIntervalMultiplier(_slowSpeedIntervalMultiplier),
+      stopIndex(0),
+      stopMode(STOP_ONLY),
+      stopRequests(0),
+      paused(false),
+      moving(false),
+      underruns(0),
+      timelineGapMicros(0)
 {
+    slowMultiplierFixed = round(slowSpeedIntervalMultiplier * (1 << FIXED_POINT_SHIFT));
+    applyInterval(_minimumInterval);
+    startSpeedSquared = toSpeedSquared(maximumInterval);
+    // Feed rates can run steps faster than the current interval, so plan from the fastest any step may go
+    fastestSpeedSquared = toSpeedSquared(minimumInterval);
+    currentSpeedSquared = startSpeedSquared;
 }
 
 void PolarMotorCoordinator::init()
@@ -48,9 +61,50 @@ void PolarMotorCoordinator::begin()
     azimuth->begin();
 }
 
+void PolarMotorCoordinator::setAcceleration(const double stepsPerSecondSquared)
+{
+    acceleration = stepsPerSecondSquared > 0 ? stepsPerSecondSquared : 0;
+    twoAcceleration = acceleration > 0 ? round(2 * acceleration) : 0;
+    if (acceleration > 0 && twoAcceleration == 0)
+        twoAcceleration = 1;
+}
+
+void PolarMotorCoordinator::attachTimer(StepTimer *timer)
+{
+    detachTimer();
+    this->timer = timer;
+    if (timer != NULL)
+        timer->schedule(timer->now(), &PolarMotorCoordinator::onAlarm, this);
+}
+
+void PolarMotorCoordinator::detachTimer()
+{
+    if (timer != NULL)
+        timer->cancel();
+    timer = NULL;
+}
+
+void PolarMotorCoordinator::onAlarm(void *context)
+{
+    PolarMotorCoordinator *coordinator = (PolarMotorCoordinator *)context;
+    StepTimer *timer = coordinator->timer;
+    if (timer == NULL)
+        return;
+
+    unsigned long currentMicros = timer->now();
+    coordinator->service(currentMicros);
+
+    timer->schedule(coordinator->findNextServiceTime(currentMicros), &PolarMotorCoordinator::onAlarm, coordinator);
+}
+
+void PolarMotorCoordinator::setStepPins(StepPins *pins)
+{
+    this->pins = pins;
+}
+
 bool PolarMotorCoordinator::canAddSteps()
 {
-    return savingIndex != movingIndex;
+    return !steps.isFull();
 }
 
 void PolarMotorCoordinator::changeStepInterval(const unsigned long interval)
@@ -60,164 +114,618 @@ void PolarMotorCoordinator::changeStepInterval(const unsigned long interval)
     if (stepInterval > maximumInterval) stepInterval = maximumInterval;
     else if (stepInterval < minimumInterval) stepInterval = minimumInterval;
 
-    if (stepInterval != currentInterval)
+    // The consumer side picks up the change, and recalculates the current move, on its next call
+    currentInterval.store(stepInterval, std::memory_order_release);
+}
+
+void PolarMotorCoordinator::addSteps(const long radiusStep, const long azimuthStep, const bool fastStep)
+{
+    queueStep(radiusStep, azimuthStep, fastStep, 0);
+}
+
+int PolarMotorCoordinator::addSteps(const Step *steps, const int count)
+{
+    return addSteps(steps, NULL, count);
+}
+
+int PolarMotorCoordinator::addSteps(const Step *steps, const unsigned long *intervals, const int count)
+{
+    int added = 0;
+
+    while (added < count && queueStep(steps[added].getRadiusStep(), steps[added].getAzimuthStep(), steps[added].isFast(), intervals != NULL ? intervals[added] : 0))
+        added++;
+
+    return added;
+}
+
+bool PolarMotorCoordinator::queueStep(const long radiusStep, const long azimuthStep, const bool fastStep, const unsigned long interval)
+{
+    // From here on steps are in motor terms, so the compensation for the interlock is part of the same planned move
+    long radiusMotorStep = toRadiusMotorSteps(radiusStep, azimuthStep);
+    long largest = abs(radiusMotorStep) > abs(azimuthStep) ? abs(radiusMotorStep) : abs(azimuthStep);
+
+    // A step too large for the queue's storage goes in as several equal pieces, all or none of them
+    long pieces = largest > PendingStep::MAX_DELTA ? (largest + PendingStep::MAX_DELTA - 1) / PendingStep::MAX_DELTA : 1;
+    if (steps.getFreeCount() < pieces)
+        return false;
+
+    // A step that moves neither motor has nothing to run, and would look like an origin
+    if (largest == 0)
+        return true;
+
+    for (long piece = 0; piece < pieces; piece++)
     {
-        currentInterval = stepInterval;
-        recalculateMove();
+        long radiusPiece = radiusMotorStep * (piece + 1) / pieces - radiusMotorStep * piece / pieces;
+        long azimuthPiece = azimuthStep * (piece + 1) / pieces - azimuthStep * piece / pieces;
+        queueMotorStep(radiusPiece, azimuthPiece, fastStep, interval);
     }
+
+    return true;
 }
 
-void PolarMotorCoordinator::addSteps(const long radiusStep, const long azimuthStep, const bool fastStep)
+void PolarMotorCoordinator::queueMotorStep(const long radiusStep, const long azimuthStep, const bool fastStep, const unsigned long interval)
+{
+    Step step;
+    step.setStepsWithSpeed(radiusStep, azimuthStep, fastStep);
+
+    // A step queued behind an idle coordinator, or behind an origin change, starts from a standstill.  Without
+    // acceleration there is nothing to plan, and the junction is skipped.
+    bool idle = !isMoving() || originAtTail;
+    int index = steps.getTailIndex();
+    PendingStep &queued = steps.back();
+    queued.setStep(radiusStep, azimuthStep, fastStep, interval);
+    if (idle || twoAcceleration == 0)
+        queued.setMaxEntrySpeedSquared(startSpeedSquared);
+    else
+        queued.setMaxEntrySpeedSquared(findJunctionSpeedSquared(lastAddedStep, lastAddedInterval, step, interval));
+    queued.setPlannedEntrySpeedSquared(findPlannedEntrySpeedSquared(queued, startSpeedSquared));
+    lastAddedStep.setSteps(step);
+    lastAddedInterval = interval;
+    originAtTail = false;
+
+    steps.push();
+    if (twoAcceleration > 0)
+        planEntrySpeeds(index);
+}
+
+bool PolarMotorCoordinator::declareOrigin()
 {
-    if (!canAddSteps())
+    // The motors have to stop at an origin, and the steps after it start from a standstill
+    if (steps.isFull())
+        return false;
+
+    PendingStep &queued = steps.back();
+    queued.setStep(0, 0, true, 0);
+    queued.setMaxEntrySpeedSquared(startSpeedSquared);
+    queued.setPlannedEntrySpeedSquared(startSpeedSquared);
+    originAtTail = true;
+
+    steps.push();
+    return true;
+}
+
+void PolarMotorCoordinator::move()
+{
+    if (timer != NULL)
         return;
 
-    steps[savingIndex].setStepsWithSpeed(radiusStep, azimuthStep, fastStep);
-    savingIndex = getNextIndex(savingIndex);
+    service(micros());
 }
 
-void PolarMotorCoordinator::declareOrigin()
+unsigned long PolarMotorCoordinator::findNextServiceTime(const unsigned long currentMicros)
 {
-    pendingOriginIndex = savingIndex;
+    unsigned long nextMicros = hasMoveSteps() && !wasPaused ? nextStepTime : currentMicros + maximumInterval;
+
+    // Come back early for any pulse that still has to be dropped
+    if (radius->isPulsing() && (long)(radius->getPulseEndTime() - nextMicros) < 0)
+        nextMicros = radius->getPulseEndTime();
+    if (azimuth->isPulsing() && (long)(azimuth->getPulseEndTime() - nextMicros) < 0)
+        nextMicros = azimuth->getPulseEndTime();
+
+    return nextMicros;
 }
 
-void PolarMotorCoordinator::move()
+void PolarMotorCoordinator::service(const unsigned long currentMicros)
 {
-    if (paused)
+    finishPulses(currentMicros);
+
+    handleRequests(currentMicros);
+    if (wasPaused)
+        return;
+    // The next move may change direction, which the drivers only allow once the last step's pulse has been dropped
+    if (!hasMoveSteps() && isPulsing())
         return;
-    if (!radius->canMove() && !azimuth->canMove() && !prepareMove())
+    if (!hasMoveSteps() && !prepareMove(currentMicros))
     {
         if (moving)
+        {
+            // The motors ran dry, either waiting on the planner or at the end of a drawing
             moving = false;
+            continuous = false;
+            underruns.store(underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
         return;
     }
 
     if (!moving)
         moving = true;
-    unsigned long currentMicros = micros();
-    radius->move(currentMicros);
-    azimuth->move(currentMicros);
+    if ((long)(currentMicros - nextStepTime) < 0)
+        return;
+
+    bool minorStep = false;
+    majorProgress++;
+    minorError -= minorSteps;
+    if (minorError < 0)
+    {
+        minorError += majorSteps;
+        minorStep = true;
+    }
+    startPulses(currentMicros, minorStep);
+
+    if (twoAcceleration > 0)
+        accelerate();
+    lastStepTime = nextStepTime;
+    nextStepTime += majorInterval;
+    continuous = true;
+}
+
+void PolarMotorCoordinator::finishPulses(const unsigned long currentMicros)
+{
+    if (pins == NULL)
+    {
+        radius->service(currentMicros);
+        azimuth->service(currentMicros);
+        return;
+    }
+
+    unsigned long mask = radius->takeFinishedPulse(currentMicros) | azimuth->takeFinishedPulse(currentMicros);
+    if (mask != 0)
+        pins->clear(mask);
+}
+
+void PolarMotorCoordinator::startPulses(const unsigned long currentMicros, const bool minorStep)
+{
+    // Both pulses are raised together and dropped together by a later call, so they overlap
+    if (pins == NULL)
+    {
+        majorMotor->step(currentMicros);
+        if (minorStep)
+            minorMotor->step(currentMicros);
+        return;
+    }
+
+    // Any pulse still up from a step interval shorter than the pulse width is cut short, so there is still an edge
+    unsigned long cutMask = majorMotor->takePulse() | (minorStep ? minorMotor->takePulse() : 0);
+    if (cutMask != 0)
+        pins->clear(cutMask);
+
+    unsigned long mask = majorMotor->beginStep(currentMicros) | (minorStep ? minorMotor->beginStep(currentMicros) : 0);
+    if (mask != 0)
+        pins->set(mask);
 }
 
 void PolarMotorCoordinator::reset()
 {
-    stop();
-    setCurrentStep(radius->getPosition() * -1, azimuth->getPosition() * -1, true);
+    stopIndex.store(steps.getTailIndex(), std::memory_order_relaxed);
+    stopMode.store(STOP_AND_RESET, std::memory_order_relaxed);
+    stopRequests.store(stopRequests.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
 void PolarMotorCoordinator::pause()
 {
-    paused = true;
+    paused.store(true, std::memory_order_release);
 }
 
 void PolarMotorCoordinator::resume()
 {
-    paused = false;
-    recalculateMove();
+    paused.store(false, std::memory_order_release);
 }
 
 void PolarMotorCoordinator::stop()
 {
-    radius->setupMove(0, 0, 0);
-    azimuth->setupMove(0, 0, 0);
-    currentStep.setStepsWithSpeed(0, 0, false);
-    moving = false;
-    while (hasSteps()) movingIndex = getNextIndex(movingIndex);
+    // Only the steps queued so far are dropped, anything added after this call still runs
+    stopIndex.store(steps.getTailIndex(), std::memory_order_relaxed);
+    stopMode.store(STOP_ONLY, std::memory_order_relaxed);
+    stopRequests.store(stopRequests.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
-bool PolarMotorCoordinator::isMoving()
+void PolarMotorCoordinator::handleRequests(const unsigned long currentMicros)
 {
-    return moving || hasSteps();
+    int requests = stopRequests.load(std::memory_order_acquire);
+    if (requests != stopsHandled)
+    {
+        stopsHandled = requests;
+        radius->setupMove(0, 0, 0);
+        azimuth->setupMove(0, 0, 0);
+        currentStep.setStepsWithSpeed(0, 0, false);
+        majorMotor = NULL;
+        moving = false;
+        continuous = false;
+        currentSpeedSquared = startSpeedSquared;
+
+        // Origins declared before the stop still take effect, only the moves are dropped
+        int stopAt = stopIndex.load(std::memory_order_relaxed);
+        while (!steps.isEmpty() && steps.getHeadIndex() != stopAt)
+        {
+            if (steps.peek(0).isOrigin())
+            {
+                radius->declareOrigin();
+                azimuth->declareOrigin();
+            }
+            steps.pop();
+        }
+
+        if (stopMode.load(std::memory_order_relaxed) == STOP_AND_RESET)
+        {
+            entrySpeedSquared = exitSpeedSquared = startSpeedSquared;
+            activeStep.setStepsWithSpeed(radius->getPosition() * -1, azimuth->getPosition() * -1, true);
+            activeInterval = 0;
+            moving = setCurrentStep(activeStep.getRadiusStep(), activeStep.getAzimuthStep(), true, activeInterval, currentMicros);
+        }
+    }
+
+    bool isPaused = paused.load(std::memory_order_acquire);
+    unsigned long interval = currentInterval.load(std::memory_order_acquire);
+    if (isPaused != wasPaused || interval != appliedInterval)
+    {
+        // Coming out of a pause restarts from a standstill, while a new interval carries on at the current speed
+        if (wasPaused && !isPaused)
+            currentSpeedSquared = startSpeedSquared;
+        if (isPaused)
+            continuous = false;
+        wasPaused = isPaused;
+        if (interval != appliedInterval)
+            applyInterval(interval);
+        if (!isPaused)
+            recalculateMove(currentMicros);
+    }
 }
 
-int PolarMotorCoordinator::getNextIndex(int index)
+bool PolarMotorCoordinator::isMoving()
 {
-    return (index + 1) % MAX_PENDING_STEPS;
+    return moving || !steps.isEmpty();
 }
 
-bool PolarMotorCoordinator::hasSteps()
+bool PolarMotorCoordinator::hasMoveSteps()
 {
-    return getNextIndex(movingIndex) != savingIndex;
+    return majorMotor != NULL && majorProgress < majorSteps;
 }
 
-bool PolarMotorCoordinator::prepareMove()
+bool PolarMotorCoordinator::isPulsing()
 {
-    int nextMovingIndex = getNextIndex(movingIndex);
+    return radius->isPulsing() || azimuth->isPulsing();
+}
 
-    if (nextMovingIndex == pendingOriginIndex) {
+bool PolarMotorCoordinator::prepareMove(const unsigned long currentMicros)
+{
+    // A stop may have been requested just before the step now visible was added, and has to drop the ones before it.
+    // So whatever is at the head is only acted on once the stops made before it was added have been handled, and each
+    // origin reached applies now that the steps before it have run.
+    while (true)
+    {
+        int head = steps.getHeadIndex();
+        bool empty = steps.isEmpty();
+        handleRequests(currentMicros);
+        if (hasMoveSteps()) {
+            return true;
+        }
+        if (empty) {
+            currentStep.setStepsWithSpeed(0, 0, false);
+            return false;
+        }
+        // A stop that dropped steps leaves a new head, which is looked at again
+        if (steps.getHeadIndex() != head) {
+            continue;
+        }
+        if (!steps.peek(0).isOrigin()) {
+            break;
+        }
         radius->declareOrigin();
         azimuth->declareOrigin();
-        pendingOriginIndex = -1;
+        steps.pop();
     }
-
-    if (nextMovingIndex == savingIndex) {
-        currentStep.setStepsWithSpeed(0, 0, false);
+    if (wasPaused) {
         return false;
     }
 
-    movingIndex = getNextIndex(movingIndex);
-    Step nextStep = steps[movingIndex];
+    PendingStep &queued = steps.peek(0);
+    activeStep.setStepsWithSpeed(queued.getRadiusStep(), queued.getAzimuthStep(), queued.isFast());
+    activeInterval = queued.getInterval();
 
-    return setCurrentStep(nextStep.getRadiusStep(), nextStep.getAzimuthStep(), nextStep.isFast());
+    // Whatever speed the last step ended at carries into this one, as far as the junction allows
+    unsigned long maxEntrySpeedSquared = queued.getMaxEntrySpeedSquared();
+    entrySpeedSquared = currentSpeedSquared < maxEntrySpeedSquared ? currentSpeedSquared : maxEntrySpeedSquared;
+    steps.pop();
+    // Without acceleration every move runs at its cruise speed, which the fastest speed only caps
+    exitSpeedSquared = twoAcceleration > 0 ? planExitSpeedSquared() : fastestSpeedSquared;
+
+    return setCurrentStep(activeStep.getRadiusStep(), activeStep.getAzimuthStep(), activeStep.isFast(), activeInterval, currentMicros);
 }
 
-void PolarMotorCoordinator::recalculateMove()
+void PolarMotorCoordinator::recalculateMove(const unsigned long currentMicros)
 {
-    if (!moving)
+    if (!hasMoveSteps())
         return;
 
-    Step nextStep = steps[movingIndex];
-    long nextRadiusSteps = nextStep.getRadiusStep() - radius->getCurrentStep();
-    long nextAzimuthSteps = nextStep.getAzimuthStep() - azimuth->getCurrentStep();
-    bool fastStep = nextStep.isFast();
+    entrySpeedSquared = currentSpeedSquared;
+    long nextRadiusSteps = activeStep.getRadiusStep() - radius->getCurrentStep();
+    long nextAzimuthSteps = activeStep.getAzimuthStep() - azimuth->getCurrentStep();
+    activeStep.setStepsWithSpeed(nextRadiusSteps, nextAzimuthSteps, activeStep.isFast());
 
-    setCurrentStep(nextRadiusSteps, nextAzimuthSteps, fastStep);
+    setCurrentStep(nextRadiusSteps, nextAzimuthSteps, activeStep.isFast(), activeInterval, currentMicros);
 }
 
-bool PolarMotorCoordinator::setCurrentStep(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep)
+bool PolarMotorCoordinator::setCurrentStep(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep, const unsigned long interval, const unsigned long currentMicros)
 {
     currentStep.setStepsWithSpeed(nextRadiusSteps, nextAzimuthSteps, fastStep);
-    return setupMove(nextRadiusSteps, nextAzimuthSteps, fastStep);
+    return setupMove(nextRadiusSteps, nextAzimuthSteps, fastStep, interval, currentMicros);
+}
+
+void PolarMotorCoordinator::applyInterval(const unsigned long interval)
+{
+    // Worked out once per change of speed, rather than once per move.  The multiplier is 16.16 fixed point.
+    appliedInterval = interval;
+    fastMoveInterval = interval;
+    slowMoveInterval = ((uint64_t)interval * slowMultiplierFixed + (1 << (FIXED_POINT_SHIFT - 1))) >> FIXED_POINT_SHIFT;
+}
+
+unsigned long PolarMotorCoordinator::getMajorInterval(const bool fastStep, const unsigned long interval)
+{
+    if (interval > 0)
+        return interval > maximumInterval ? maximumInterval : interval < minimumInterval ? minimumInterval : interval;
+
+    return fastStep ? fastMoveInterval : slowMoveInterval;
 }
 
-bool PolarMotorCoordinator::setupMove(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep)
+bool PolarMotorCoordinator::setupMove(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep, const unsigned long interval, const unsigned long currentMicros)
 {
     long rSteps = abs(nextRadiusSteps);
     long aSteps = abs(nextAzimuthSteps);
     long maxSteps = rSteps > aSteps ? rSteps : aSteps;
 
     if (maxSteps == 0)
+    {
+        majorMotor = NULL;
         return false;
+    }
 
-    unsigned long moveTime = round(maxSteps * currentInterval * (fastStep ? 1 : slowSpeedIntervalMultiplier));
-    unsigned long radiusStepTimeDelta = moveTime / rSteps;
-    unsigned long azimuthStepTimeDelta = moveTime / aSteps;
-    unsigned long currentMicros = micros();
+    majorInterval = getMajorInterval(fastStep, interval);
+    majorMotor = rSteps >= aSteps ? radius : azimuth;
+    minorMotor = rSteps >= aSteps ? azimuth : radius;
+    majorSteps = maxSteps;
+    minorSteps = rSteps >= aSteps ? aSteps : rSteps;
+    majorProgress = 0;
+    minorError = majorSteps / 2;
+
+    if (twoAcceleration > 0)
+    {
+        // Start at the entry speed, and let accelerate() ramp the interval after each step of the major axis
+        cruiseSpeedSquared = toSpeedSquared(majorInterval);
+        if (cruiseSpeedSquared < startSpeedSquared)
+            cruiseSpeedSquared = startSpeedSquared;
+        currentSpeedSquared = entrySpeedSquared < cruiseSpeedSquared ? entrySpeedSquared : cruiseSpeedSquared;
+        rampUpSpeedSquared = entrySpeedSquared;
+        rampDownSpeedSquared = exitSpeedSquared + (uint64_t)twoAcceleration * majorSteps;
+        majorInterval = toInterval(currentSpeedSquared);
+    }
 
-    radius->setupMove(nextRadiusSteps, currentMicros, radiusStepTimeDelta);
-    azimuth->setupMove(nextAzimuthSteps, currentMicros, azimuthStepTimeDelta);
+    // The motors only track direction and counts, the coordinator decides when each of them steps
+    scheduleFirstStep(currentMicros);
+    radius->setupMove(nextRadiusSteps, currentMicros, 0);
+    azimuth->setupMove(nextAzimuthSteps, currentMicros, 0);
+
+    // A direction change holds off the first step until the driver has seen the new direction
+    if (!radius->isReady(nextStepTime))
+        nextStepTime = radius->getDirectionReadyTime();
+    if (!azimuth->isReady(nextStepTime))
+        nextStepTime = azimuth->getDirectionReadyTime();
 
     return true;
 }
 
+void PolarMotorCoordinator::scheduleFirstStep(const unsigned long currentMicros)
+{
+    if (!continuous)
+    {
+        nextStepTime = currentMicros + majorInterval;
+        return;
+    }
+
+    // The motors have not stopped since the last step, so carry on the step train from when that step was due.  A
+    // first step that is already overdue goes right away, and the time lost is added to the gap telemetry.
+    unsigned long idealStepTime = lastStepTime + majorInterval;
+    long late = (long)(currentMicros - idealStepTime);
+    if (late > 0)
+    {
+        nextStepTime = currentMicros;
+        timelineGapMicros.store(timelineGapMicros.load(std::memory_order_relaxed) + late, std::memory_order_relaxed);
+    }
+    else
+    {
+        nextStepTime = idealStepTime;
+    }
+}
+
+unsigned long PolarMotorCoordinator::toSpeedSquared(const unsigned long interval)
+{
+    unsigned long speed = interval > 0 ? (1000000 + interval / 2) / interval : MAX_PLANNED_SPEED;
+    if (speed > MAX_PLANNED_SPEED)
+        speed = MAX_PLANNED_SPEED;
+    return speed * speed;
+}
+
+unsigned long PolarMotorCoordinator::integerSqrt(const unsigned long value)
+{
+    // Bit by bit, so stepping never touches floating point (which is done in software on the M0+)
+    unsigned long remainder = value;
+    unsigned long root = 0;
+    unsigned long bit = 1UL << 30;
+    while (bit > remainder)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (remainder >= root + bit)
+        {
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+unsigned long PolarMotorCoordinator::toInterval(const unsigned long speedSquared)
+{
+    unsigned long speed = integerSqrt(speedSquared);
+    return speed > 0 ? (1000000 + speed / 2) / speed : maximumInterval;
+}
+
+double PolarMotorCoordinator::getMoveInterval(const bool fastStep, const unsigned long interval, const unsigned long stepInterval)
+{
+    // A feed rate sets its own interval, within the limits, and otherwise the speed is the current interval's
+    if (interval > 0)
+        return interval > maximumInterval ? maximumInterval : interval < minimumInterval ? minimumInterval : interval;
+
+    return stepInterval * (fastStep ? 1 : slowSpeedIntervalMultiplier);
+}
+
+double PolarMotorCoordinator::getCruiseSpeedSquared(const bool fastStep, const unsigned long interval)
+{
+    double speed = 1000000.0 / getMoveInterval(fastStep, interval, currentInterval.load(std::memory_order_relaxed));
+    return speed * speed > startSpeedSquared ? speed * speed : startSpeedSquared;
+}
+
+double PolarMotorCoordinator::findJunctionSpeedSquared(const Step &previous, const unsigned long previousInterval, const Step &next, const unsigned long nextInterval)
+{
+    // Scale between the start speed for a reversal or right angle and the cruise speed for a straight continuation,
+    // by the cosine of the angle between the two steps (measured in motor steps)
+    double previousR = previous.getRadiusStep(), previousA = previous.getAzimuthStep();
+    double nextR = next.getRadiusStep(), nextA = next.getAzimuthStep();
+    double lengths = sqrt((previousR * previousR + previousA * previousA) * (nextR * nextR + nextA * nextA));
+    double cosine = lengths > 0 ? (previousR * nextR + previousA * nextA) / lengths : 0;
+
+    if (cosine <= 0)
+        return startSpeedSquared;
+
+    double previousCruiseSpeedSquared = getCruiseSpeedSquared(previous.isFast(), previousInterval);
+    double nextCruiseSpeedSquared = getCruiseSpeedSquared(next.isFast(), nextInterval);
+    double cruiseSpeedSquared = previousCruiseSpeedSquared < nextCruiseSpeedSquared ? previousCruiseSpeedSquared : nextCruiseSpeedSquared;
+    return startSpeedSquared + (cruiseSpeedSquared - startSpeedSquared) * cosine * cosine;
+}
+
+unsigned long PolarMotorCoordinator::findPlannedEntrySpeedSquared(const PendingStep &step, const unsigned long exitSpeedSquared)
+{
+    // As fast as the step can still slow down to its exit speed by its end, within its junction and the fastest speed
+    long rSteps = abs(step.getRadiusStep());
+    long aSteps = abs(step.getAzimuthStep());
+    uint64_t speedSquared = exitSpeedSquared + (uint64_t)twoAcceleration * (rSteps > aSteps ? rSteps : aSteps);
+    unsigned long limit = step.getMaxEntrySpeedSquared();
+    if (limit > fastestSpeedSquared)
+        limit = fastestSpeedSquared;
+    return speedSquared < limit ? speedSquared : limit;
+}
+
+void PolarMotorCoordinator::planEntrySpeeds(const int newestIndex)
+{
+    // Producer: walk back from the step just added towards the oldest still queued, raising each planned entry speed
+    // now that there is more room to slow down after it.  Once one comes out unchanged, none before it can change
+    // either, so a long queue is only walked as far as the newest step makes a difference.
+    int headIndex = steps.getHeadIndex();
+    int index = newestIndex;
+    while (index != headIndex)
+    {
+        unsigned long nextSpeedSquared = steps.at(index).getPlannedEntrySpeedSquared();
+        index = PendingStepQueue::getPreviousIndex(index);
+        PendingStep &step = steps.at(index);
+        unsigned long plannedSpeedSquared = step.getPlannedEntrySpeedSquared();
+        step.setPlannedEntrySpeedSquared(findPlannedEntrySpeedSquared(step, nextSpeedSquared));
+        if (step.getPlannedEntrySpeedSquared() == plannedSpeedSquared)
+            break;
+    }
+}
+
+unsigned long PolarMotorCoordinator::planExitSpeedSquared()
+{
+    // Consumer: the steps after the current one were planned as they were queued, so this is a single read
+    return steps.isEmpty() ? startSpeedSquared : steps.peek(0).getPlannedEntrySpeedSquared();
+}
+
+void PolarMotorCoordinator::accelerate()
+{
+    // Trapezoid: the slowest of speeding up from the entry, cruising, and slowing down in time for the exit
+    rampUpSpeedSquared += twoAcceleration;
+    rampDownSpeedSquared -= twoAcceleration;
+    uint64_t speedSquared = rampUpSpeedSquared < rampDownSpeedSquared ? rampUpSpeedSquared : rampDownSpeedSquared;
+    if (speedSquared > cruiseSpeedSquared)
+        speedSquared = cruiseSpeedSquared;
+    currentSpeedSquared = speedSquared;
+
+    if (majorProgress < majorSteps)
+        majorInterval = toInterval(currentSpeedSquared);
+}
+
+int PolarMotorCoordinator::getQueueCapacity()
+{
+    return PendingStepQueue::getCapacity();
+}
+
+int PolarMotorCoordinator::getQueueHighWaterMark()
+{
+    return steps.getHighWaterMark();
+}
+
+unsigned long PolarMotorCoordinator::getQueueUnderruns()
+{
+    return underruns.load(std::memory_order_relaxed);
+}
+
+unsigned long PolarMotorCoordinator::getTimelineGapMicros()
+{
+    return timelineGapMicros.load(std::memory_order_relaxed);
+}
+
+void PolarMotorCoordinator::resetQueueStats()
+{
+    steps.resetHighWaterMark();
+    underruns.store(0, std::memory_order_relaxed);
+    timelineGapMicros.store(0, std::memory_order_relaxed);
+}
+
 unsigned long PolarMotorCoordinator::getStepInterval()
 {
-    return currentInterval;
+    return currentInterval.load(std::memory_order_relaxed);
+}
+
+long PolarMotorCoordinator::toRadiusMotorSteps(const long radiusSteps, const long azimuthSteps)
+{
+    // The azimuth already drags the radius by interlocked steps for each of its own, so the radius motor makes up the rest
+    return radiusSteps - interlocked * azimuthSteps;
+}
+
+long PolarMotorCoordinator::toRadiusSteps(const long radiusMotorSteps, const long azimuthSteps)
+{
+    return radiusMotorSteps + interlocked * azimuthSteps;
 }
 
 Step PolarMotorCoordinator::getCurrentPosition()
 {
-    currentPosition.setStepsWithSpeed(radius->getPosition(), azimuth->getPosition(), true);
+    currentPosition.setStepsWithSpeed(toRadiusSteps(radius->getPosition(), azimuth->getPosition()), azimuth->getPosition(), true);
     return currentPosition;
 }
 
 Step PolarMotorCoordinator::getCurrentProgress()
 {
-    currentProgress.setStepsWithSpeed(radius->getCurrentStep(), azimuth->getCurrentStep(), false);
+    currentProgress.setStepsWithSpeed(toRadiusSteps(radius->getCurrentStep(), azimuth->getCurrentStep()), azimuth->getCurrentStep(), false);
     return currentProgress;
 }
 
 Step PolarMotorCoordinator::getCurrentStep()
 {
-    return currentStep;
+    Step step;
+    step.setStepsWithSpeed(toRadiusSteps(currentStep.getRadiusStep(), currentStep.getAzimuthStep()), currentStep.getAzimuthStep(), currentStep.isFast());
+    return step;
 }
@@ -25,10 +25,34 @@
 #define _POLARPLOTTERCORE_POLARMOTORCOORDINATOR_H_
 
 #include "stepDirMotor.h"
+#include "stepTimer.h"
+#include "stepPins.h"
+#include "stepQueue.h"
 #include "step.h"
 
+// The queue's size and layout are chosen at build time, for example -DMAX_PENDING_STEPS=4000 -DPACKED_PENDING_STEPS.
+// Packed steps take 10 bytes rather than 24 on the RP2040, splitting any step larger than 32767 on either axis into pieces.
+#ifndef MAX_PENDING_STEPS
 #define MAX_PENDING_STEPS 100
+#endif
+
+#ifdef PACKED_PENDING_STEPS
+typedef PackedQueuedStep PendingStep;
+#else
+typedef QueuedStep PendingStep;
+#endif
+typedef StepQueue<MAX_PENDING_STEPS, PendingStep> PendingStepQueue;
+
+#define FIXED_POINT_SHIFT 16
+
+#define STOP_ONLY 0
+#define STOP_AND_RESET 1
 
+// The coordinator is split between a producer side (addSteps, declareOrigin, stop, reset, pause, resume and
+// changeStepInterval) and a consumer side (move, or the attached timer's alarm).  On the RP2040 the planner and
+// controller run on core 0 and the move() loop runs on core 1; the two only meet through the lock-free step queue and
+// a few atomic request fields, so neither side ever waits on the other.  The status getters read consumer state
+// without synchronization, and are only meant for display.
 class PolarMotorCoordinator
 {
 private:
@@ -38,28 +62,120 @@ private:
     // Interlocked != 0 means that azimuth and radius are physically connected, such that turning the azimuth results in a change in radius
     // A positive value indicates that one step of the azimuth results in one or more steps of the radius in the same direction (value of interlocked is the # of steps)
     // A negative value indicates that one step of the azimuth results in one or more steps of the radius in the opposite direction
+    // Steps are added in terms of where the ball should go, and queued in terms of motor steps, with the radius motor
+    // taking the azimuth's drag off its own steps, so the compensation is planned and stepped as part of the same move
     int interlocked;
     unsigned long minimumInterval;
     unsigned long maximumInterval;
-    unsigned long currentInterval;
+    std::atomic<unsigned long> currentInterval;
     double slowSpeedIntervalMultiplier;
-    Step steps[MAX_PENDING_STEPS];
+
+    // The consumer side's copy of the current interval, and the major axis intervals for fast and slow steps that
+    // follow from it, so that setting up a move is only integer comparisons
+    unsigned long appliedInterval;
+    unsigned long fastMoveInterval;
+    unsigned long slowMoveInterval;
+    unsigned long slowMultiplierFixed;
+    PendingStepQueue steps;
+
+    // Acceleration planning.  Speeds are in whole steps per second of whichever axis moves the most in a step, and are
+    // kept squared, so that planning across the queue is additions and comparisons (v^2 = u^2 + 2as).  The fastest each
+    // queued step may be entered is fixed when it is added, from the change of direction at the junction with the one
+    // before it.  Each step added is planned to stop at its end, and the planned entry speeds of the steps before it
+    // are raised until one comes out unchanged, so the motors can always slow down to the maximumInterval speed by the
+    // end of the queue.  A move's exit speed is then just the planned entry speed of the step after it.
+    double acceleration = 0;
+    unsigned long twoAcceleration = 0;
+    unsigned long startSpeedSquared;
+    unsigned long fastestSpeedSquared;
+    Step lastAddedStep;
+    unsigned long lastAddedInterval = 0;
+
+    // The consumer side ramps in integers: the speed squared to either side of each step is the ramp up from the entry
+    // speed and the ramp down to the exit speed, each moved on by 2a per step, and the interval comes from an integer
+    // square root of the lower of the two
+    unsigned long entrySpeedSquared = 0;
+    unsigned long exitSpeedSquared = 0;
+    unsigned long cruiseSpeedSquared = 0;
+    unsigned long currentSpeedSquared = 0;
+    uint64_t rampUpSpeedSquared = 0;
+    uint64_t rampDownSpeedSquared = 0;
+
+    // The coordinator owns the step timeline.  The axis with the most steps in a move (the major axis) steps every
+    // majorInterval, and the other axis steps alongside it whenever the Bresenham error term rolls over.  The minor
+    // steps are spread evenly across the move and always complete by its last tick, with no per-move division.
+    StepDirMotor *majorMotor = NULL;
+    StepDirMotor *minorMotor = NULL;
+    long majorSteps = 0;
+    long minorSteps = 0;
+    long majorProgress = 0;
+    long minorError = 0;
+    unsigned long majorInterval = 0;
+    unsigned long nextStepTime = 0;
+
+    // While the motors keep moving, each move's first step is timed from the last step of the one before, rather
+    // than from when the move happened to be set up, so the step train runs on across moves without dead time
+    bool continuous = false;
+    unsigned long lastStepTime = 0;
+
+    // When a timer is attached, its alarm drives the steps instead of calls to move()
+    StepTimer *timer = NULL;
+
+    static void onAlarm(void *context);
+
+    // When pins are set, the step pulses of both motors are raised and dropped through them in one write each
+    StepPins *pins = NULL;
+
+    void finishPulses(const unsigned long currentMicros);
+    void startPulses(const unsigned long currentMicros, const bool minorStep);
+    unsigned long findNextServiceTime(const unsigned long currentMicros);
+
+    // Origins are queued in their place among the steps, as empty steps.  Stop requests from the producer side are
+    // published by bumping a counter after writing their details, and the consumer acts on them when its own count
+    // falls behind.
+    bool originAtTail = false;
+    std::atomic<int> stopIndex;
+    std::atomic<int> stopMode;
+    std::atomic<int> stopRequests;
+    int stopsHandled = 0;
+
+    Step activeStep;
+    unsigned long activeInterval = 0;
     Step currentStep;
     Step currentPosition;
     Step currentProgress;
-    int paused = false;
-    int moving = false;
-    int movingIndex = 0;
-    int savingIndex = 1;
-    int pendingOriginIndex = -1;
+    std::atomic<bool> paused;
+    bool wasPaused = false;
+    std::atomic<bool> moving;
+    std::atomic<unsigned long> underruns;
+    std::atomic<unsigned long> timelineGapMicros;
 
 protected:
-    int getNextIndex(int index);
-    bool prepareMove();
-    void recalculateMove();
-    bool hasSteps();
-    bool setCurrentStep(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep);
-    bool setupMove(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep);
+    void service(const unsigned long currentMicros);
+    void handleRequests(const unsigned long currentMicros);
+    bool prepareMove(const unsigned long currentMicros);
+    bool hasMoveSteps();
+    bool isPulsing();
+    void recalculateMove(const unsigned long currentMicros);
+    bool setCurrentStep(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep, const unsigned long interval, const unsigned long currentMicros);
+    void applyInterval(const unsigned long interval);
+    unsigned long getMajorInterval(const bool fastStep, const unsigned long interval);
+    bool setupMove(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep, const unsigned long interval, const unsigned long currentMicros);
+    void scheduleFirstStep(const unsigned long currentMicros);
+    bool queueStep(const long radiusStep, const long azimuthStep, const bool fastStep, const unsigned long interval);
+    void queueMotorStep(const long radiusStep, const long azimuthStep, const bool fastStep, const unsigned long interval);
+    static unsigned long toSpeedSquared(const unsigned long interval);
+    static unsigned long integerSqrt(const unsigned long value);
+    unsigned long toInterval(const unsigned long speedSquared);
+    double getMoveInterval(const bool fastStep, const unsigned long interval, const unsigned long stepInterval);
+    double getCruiseSpeedSquared(const bool fastStep, const unsigned long interval);
+    double findJunctionSpeedSquared(const Step &previous, const unsigned long previousInterval, const Step &next, const unsigned long nextInterval);
+    unsigned long findPlannedEntrySpeedSquared(const PendingStep &step, const unsigned long exitSpeedSquared);
+    void planEntrySpeeds(const int newestIndex);
+    unsigned long planExitSpeedSquared();
+    long toRadiusMotorSteps(const long radiusSteps, const long azimuthSteps);
+    long toRadiusSteps(const long radiusMotorSteps, const long azimuthSteps);
+    void accelerate();
 
 public:
     /**
@@ -71,8 +187,9 @@ public:
      * @param _minimumInterval the lowest step interval that is allowed.  Setting the speed to a value below this will result in the speed being set to this value.
      * @param _maximumInterval the highest step interval that is allowed.  Setting the speed to a value above this will result in the speed being set to this value.
      * @param _slowSpeedIntervalMultiplier how many times slower is a "slow" step versus a "fast" step.  The fast step waits the current step interval between steps, while a slow step waits the current step interval times this multiplier.
-     * @param _getMicros a function pointer to the method to get the current system microseconds, so we can run in both foreground and background threads
-     * @param _delayMicros a function pointer to the method to wait for the given number of microseconds, so we can run in both foreground and background threads
+     *
+     * Steps are timed from micros() through calls to move() until a timer is attached with attachTimer(), and each motor
+     * writes its own step pin until pins are given with setStepPins().
      */
     PolarMotorCoordinator(StepDirMotor *_radius, StepDirMotor *_azimuth,
                           const int _interlocked, const int _minimumInterval, const int _maximumInterval,
@@ -88,6 +205,30 @@ public:
      */
     void begin();
 
+    /**
+     * Sets the acceleration, in steps per second per second, used to ramp the step interval between the maximum
+     * interval (the speed the motors can start and stop at) and the current interval.  Zero, the default, disables
+     * ramping, so every step runs at the current interval from start to finish.
+     */
+    virtual void setAcceleration(const double stepsPerSecondSquared);
+
+    /**
+     * Drives the steps from the given timer's alarm, which is re-armed for the exact time of each next step (or polls
+     * at the maximum interval while there is nothing to do).  Once attached, move() does nothing, and the foreground
+     * only has to keep the queue filled.
+     */
+    virtual void attachTimer(StepTimer *timer);
+
+    /** Stops driving the steps from the attached timer, going back to calls to move(). */
+    virtual void detachTimer();
+
+    /**
+     * Writes the step pulses of both motors through the given pins, one masked write to raise both and one to drop
+     * them, instead of each motor writing its own pin.  Passing NULL goes back to the motors writing their own pins.
+     * The direction pins are always written by the motors.
+     */
+    virtual void setStepPins(StepPins *pins);
+
     /** Returns whether we can accept new steps at the current time. */
     virtual bool canAddSteps();
 
@@ -97,10 +238,23 @@ public:
     /** Adds steps to the current pending queue of steps to run.  Fast steps run using the current step interval.  Slow steps run at the current interval multiplied by the slow speed interval multiplier. */
     virtual void addSteps(const long radiusStep, const long azimuthStep, const bool fastStep);
 
-    /** Declares the current point (after any pending moves complete) as the (0, 0) origin. */
-    virtual void declareOrigin();
+    /** Adds as many of the given steps as there is room for, in order, returning how many were added. */
+    virtual int addSteps(const Step *steps, const int count);
 
-    /** Moves a single step if enough time has passed, or returns if not enough time has passed, or there are no pending steps. */
+    /**
+     * Adds as many of the given steps as there is room for, in order, returning how many were added.  Each step with a
+     * non-zero interval runs its busiest axis at that interval (kept between the minimum and maximum intervals), as set
+     * by a feed rate, instead of at the current interval.  The intervals may be NULL, for none.
+     */
+    virtual int addSteps(const Step *steps, const unsigned long *intervals, const int count);
+
+    /**
+     * Declares the current point (after any pending moves complete) as the (0, 0) origin.  The origin takes a place
+     * in the queue, so returns false, without declaring it, if the queue is full.
+     */
+    virtual bool declareOrigin();
+
+    /** Moves a single step if enough time has passed, or returns if not enough time has passed, or there are no pending steps.  Does nothing while a timer is attached. */
     virtual void move();
 
     /** Moves back to the origin, after any other pending moves complete. */
@@ -118,10 +272,25 @@ public:
     /** Returns true if there are still steps to move. */
     virtual bool isMoving();
 
+    /** Returns how many steps the queue can hold. */
+    virtual int getQueueCapacity();
+
+    /** Returns the most steps that have been waiting in the queue at once, for sizing the queue from real drawings. */
+    virtual int getQueueHighWaterMark();
+
+    /** Returns how many times the motors have run out of queued steps while moving, including at the end of each drawing. */
+    virtual unsigned long getQueueUnderruns();
+
+    /** Returns the total time, in microseconds, that moves started later than one interval after the step before them, while the motors were meant to keep moving. */
+    virtual unsigned long getTimelineGapMicros();
+
+    /** Starts the queue high-water mark, underrun count and timeline gap over, for example at the start of a drawing. */
+    virtual void resetQueueStats();
+
     /** Returns the current step interval. */
     virtual unsigned long getStepInterval();
 
-    /** Returns the current position in terms of radius steps and azimuth steps from the origin. */
+    /** Returns the current position in terms of radius steps and azimuth steps from the origin, including the radius the azimuth has dragged along with it. */
     virtual Step getCurrentPosition();
 
     /** Returns the step each motor is on, so that it can be compared with the current step to see how far along they are. */
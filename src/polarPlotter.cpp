@@ -37,7 +37,10 @@ PolarPlotter::PolarPlotter(Print &printer, StatusUpdate &statusUpdater, double m
       spiralStepper(SpiralStepper()),
       wipeStepper(WipeStepper(maxRadius)),
       currentStepper(NULL),
-      coordinator(coordinator)
+      pendingStepIndex(0),
+      pendingStepCount(0),
+      coordinator(coordinator),
+      feedRate(0)
 {
 }
 
@@ -54,30 +57,39 @@ void PolarPlotter::calibrate(double startingRadius, double startingAzimuth, doub
   this->statusUpdater.setAzimuthStepSize(azimuthStepSize);
 }
 
-void PolarPlotter::startCommand(String &command)
+void PolarPlotter::setLookahead(int depth, double maxDeviation)
+{
+  this->lineStepper.setLookahead(depth, maxDeviation);
+  this->circleStepper.setLookahead(depth, maxDeviation);
+}
+
+void PolarPlotter::setSegmentTolerance(double tolerance)
+{
+  this->lineStepper.setSegmentTolerance(tolerance);
+  this->circleStepper.setSegmentTolerance(tolerance);
+}
+
+void PolarPlotter::startCommand(const Command &command)
 {
   currentStepper = NULL;
   currentStep = 0;
+  feedRate = 0;
   statusUpdater.setCurrentStep(currentStep);
  
-  const String cmd = command;
+  const String cmd = command.toString();
   statusUpdater.setCurrentCommand(cmd);
 
-  switch (command.charAt(0))
+  switch (command.getCode())
   {
-  case 'l':
   case 'L':
     currentStepper = &lineStepper;
     break;
-  case 'c':
   case 'C':
     currentStepper = &circleStepper;
     break;
-  case 's':
   case 'S':
     currentStepper = &spiralStepper;
     break;
-  case 'w':
   case 'W':
     if (coordinator) coordinator->reset();
     currentStepper = &wipeStepper;
@@ -85,8 +97,8 @@ void PolarPlotter::startCommand(String &command)
   }
 
   if (currentStepper != NULL) {
-    String arguments = command.substring(1);
-    currentStepper->startNewLine(position, arguments);
+    if (currentStepper != &wipeStepper) feedRate = command.getFeedRate();
+    currentStepper->startNewLine(position, command);
 
     const double radius = position.getRadius();
     const double azimuth = position.getAzimuth();
@@ -96,7 +108,7 @@ void PolarPlotter::startCommand(String &command)
 
 bool PolarPlotter::hasNextStep()
 {
-  return pendingStep.hasStep() || (currentStepper != NULL && currentStepper->hasStep());
+  return pendingStepIndex < pendingStepCount || (currentStepper != NULL && currentStepper->hasStep());
 }
 
 void PolarPlotter::clearStepper()
@@ -106,33 +118,80 @@ void PolarPlotter::clearStepper()
 
 void PolarPlotter::step()
 {
-  if (pendingStep.hasStep()) {
-    if (!coordinator->canAddSteps()) return;
-    coordinator->addSteps(pendingStep.getRadiusStep(), pendingStep.getAzimuthStep(), pendingStep.isFast());
-    pendingStep.setSteps(0, 0);
+  if (pendingStepCount - pendingStepIndex <= 1 && currentStepper != NULL && currentStepper->hasStep()) {
+    // Keep a run that is still being built at the front, so the next batch can keep extending it
+    if (pendingStepIndex < pendingStepCount) {
+      pendingSteps[0].setSteps(pendingSteps[pendingStepIndex]);
+      pendingStepRuns[0] = pendingStepRuns[pendingStepIndex];
+      pendingStepIntervals[0] = pendingStepIntervals[pendingStepIndex];
+      pendingStepCount = 1;
+    } else {
+      pendingStepCount = 0;
+    }
+    pendingStepIndex = 0;
+
+    const int first = pendingStepCount;
+    const int count = currentStepper->fillSteps(&pendingSteps[first], STEP_BATCH_SIZE - first);
+
+    // Runs are merged in place, which is safe since a step never lands after the one being read
+    for (int i = first; i < first + count; i++) {
+      Step step;
+      unsigned long interval;
+      step.setSteps(pendingSteps[i]);
+      if (applyStep(step, interval)) queueStep(step, interval);
+    }
+
+    statusUpdater.setCurrentStep(currentStep);
+    statusUpdater.setPosition(position.getRadius(), position.getAzimuth());
   }
-  if (!hasNextStep()) {
-    return;
+
+  flushPendingSteps(currentStepper == NULL || !currentStepper->hasStep());
+}
+
+bool PolarPlotter::canMove()
+{
+  // Held steps go on to the coordinator first, and once they have all gone the batch starts over
+  flushPendingSteps(true);
+
+  if (pendingStepIndex >= pendingStepCount) {
+    pendingStepIndex = 0;
+    pendingStepCount = 0;
   }
 
-  Step &step = currentStepper->step();
-  const bool fastStep = currentStepper->isFastStep();
-  return moveTo(step.getRadiusStep(), step.getAzimuthStep(), fastStep);
+  return pendingStepCount < STEP_BATCH_SIZE;
+}
+
+bool PolarPlotter::moveTo(const long radiusSteps, const long azimuthSteps, const bool fastStep)
+{
+  // Refused before the step is applied, so the position never runs ahead of the steps actually queued
+  if (!canMove()) return false;
+
+  // Direct moves always run at the coordinator's own speeds
+  feedRate = 0;
+  Step step;
+  unsigned long interval;
+  step.setStepsWithSpeed(radiusSteps, azimuthSteps, fastStep);
+  if (applyStep(step, interval)) queueStep(step, interval);
+
+  statusUpdater.setCurrentStep(currentStep);
+  statusUpdater.setPosition(position.getRadius(), position.getAzimuth());
+  flushPendingSteps(true);
+  return true;
 }
 
-void PolarPlotter::moveTo(const long radiusSteps, const long azimuthSteps, const bool fastStep)
+bool PolarPlotter::applyStep(Step &step, unsigned long &interval)
 {
   double oldRadius = position.getRadius();
   double oldAzimuth = position.getAzimuth();
-  double newRadiusDelta = radiusSteps * radiusStepSize;
-  double newAzimuthDelta = azimuthSteps * azimuthStepSize;
+  double newRadiusDelta = step.getRadiusStep() * radiusStepSize;
+  double newAzimuthDelta = step.getAzimuthStep() * azimuthStepSize;
   double newRadius = oldRadius + newRadiusDelta;
   double newAzimuth = oldAzimuth + newAzimuthDelta;
-  long radiusStep = radiusSteps;
-  long azimuthStep = azimuthSteps;
+  long radiusStep = step.getRadiusStep();
+  long azimuthStep = step.getAzimuthStep();
+  bool fastStep = step.isFast();
 
   currentStep++;
-  statusUpdater.setCurrentStep(currentStep);
 
   if (newRadius >= maxRadius) { radiusStep = round((maxRadius - oldRadius) / radiusStepSize); newRadius = maxRadius; }
   if (newRadius < (radiusStepSize * 0.5)) { radiusStep = -round(oldRadius / radiusStepSize); newRadius = 0; }
@@ -140,22 +199,69 @@ void PolarPlotter::moveTo(const long radiusSteps, const long azimuthSteps, const
 
 
 #ifdef __SHOW_STEP_DETAILS__
-    std::cout << "  Stepping.  Original: (" << radiusSteps << "," << azimuthSteps << "), Adjusted: (" << radiusStep << ", " << azimuthStep << "), Fast: " << fastStep << std::endl;
+    std::cout << "  Stepping.  Original: (" << step.getRadiusStep() << "," << step.getAzimuthStep() << "), Adjusted: (" << radiusStep << ", " << azimuthStep << "), Fast: " << fastStep << std::endl;
 #endif
 #ifdef __SHOW_STEP__
     std::cout << "STEP: " << radiusStep << "," << azimuthStep << std::endl;
 #endif
 
-  if ((radiusStep != 0 || azimuthStep != 0) && coordinator)
-  {
-    if (coordinator->canAddSteps()) {
-      coordinator->addSteps(radiusStep, azimuthStep, fastStep);
-    } else {
-      pendingStep.setStepsWithSpeed(radiusStep, azimuthStep, fastStep);
+  step.setStepsWithSpeed(radiusStep, azimuthStep, fastStep);
+  position.repoint(newRadius, newAzimuth);
+
+  // With a feed rate, the step takes as long as its cartesian length needs at that speed, spread over the steps of
+  // its busiest axis.  The length is the chord between the two polar points, which grows with the radius for the
+  // same azimuth step.
+  interval = 0;
+  long majorSteps = abs(radiusStep) > abs(azimuthStep) ? abs(radiusStep) : abs(azimuthStep);
+  if (feedRate > 0 && majorSteps > 0) {
+    double radiusDelta = newRadius - oldRadius;
+    double halfAzimuthSine = sin(azimuthStep * azimuthStepSize * 0.5);
+    double length = sqrt(radiusDelta * radiusDelta + 4 * oldRadius * newRadius * halfAzimuthSine * halfAzimuthSine);
+    double micros = round(length / feedRate * 1000000.0 / majorSteps);
+    interval = micros >= 1 ? micros : 1;
+  }
+
+  return coordinator && step.hasStep();
+}
+
+void PolarPlotter::queueStep(Step &step, const unsigned long interval)
+{
+  // Consecutive identical steps trace the same motor path as one move of their sum, and only take one queue slot
+  if (pendingStepCount > pendingStepIndex) {
+    const int last = pendingStepCount - 1;
+    Step &lastStep = pendingSteps[last];
+    const int run = pendingStepRuns[last];
+
+    const unsigned long lastInterval = pendingStepIntervals[last];
+
+    if (run < MAX_COALESCED_STEPS && lastStep.isFast() == step.isFast() && (lastInterval == 0) == (interval == 0) &&
+        lastStep.getRadiusStep() == step.getRadiusStep() * run && lastStep.getAzimuthStep() == step.getAzimuthStep() * run) {
+      lastStep.setStepsWithSpeed(lastStep.getRadiusStep() + step.getRadiusStep(), lastStep.getAzimuthStep() + step.getAzimuthStep(), step.isFast());
+      // Every step of a run has the same number of major steps, so the run's interval is the average of theirs
+      pendingStepIntervals[last] = (lastInterval * run + interval + (run + 1) / 2) / (run + 1);
+      pendingStepRuns[last] = run + 1;
+      return;
     }
   }
 
-  updatePosition(newRadius, newAzimuth, position, &statusUpdater);
+  if (pendingStepCount >= STEP_BATCH_SIZE) return;
+
+  pendingSteps[pendingStepCount].setSteps(step);
+  pendingStepRuns[pendingStepCount] = 1;
+  pendingStepIntervals[pendingStepCount] = interval;
+  pendingStepCount++;
+}
+
+void PolarPlotter::flushPendingSteps(const bool includeLastRun)
+{
+  if (pendingStepIndex >= pendingStepCount || !coordinator) return;
+
+  // The last run may still grow, so hold it back unless the motors would otherwise sit idle waiting for it
+  int count = pendingStepCount - pendingStepIndex;
+  if (!includeLastRun && coordinator->isMoving()) count--;
+  if (count <= 0) return;
+
+  pendingStepIndex += coordinator->addSteps(&pendingSteps[pendingStepIndex], &pendingStepIntervals[pendingStepIndex], count);
 }
 
 Point PolarPlotter::getPosition() const
@@ -170,6 +276,7 @@ String PolarPlotter::getHelpMessage()
          "L{X},{Y}      Draw a line to the cartesian point (X,Y)\n"
          "C{X},{Y},{D}  Draw a circular arc with center at the cartesian point (X,Y) having an angle of the given degress (-180 to 180)\n"
          "S{R},{D}      Draw a spiral using R units of radius change and D degrees around\n"
+         "  ,F{S}       Optionally after L, C or S, move the marble at S units per second, at any radius\n"
          "D{#}          Set the debug level between 0-9 (0-Off, 9-Most Verbose)";
 }
 
@@ -186,9 +293,3 @@ void PolarPlotter::printStep(const long radiusStep, const long azimuthStep, cons
     msg = msg + radiusStep + "," + azimuthStep + " / " + (fastStep ? "fast" : "slow");
     statusUpdater->status("STEP:", msg);
 }
-
-void PolarPlotter::updatePosition(const double newRadius, const double newAzimuth, Point &position, StatusUpdate* statusUpdater)
-{
-  position.repoint(newRadius, newAzimuth);
-  statusUpdater->setPosition(newRadius, newAzimuth);
-}
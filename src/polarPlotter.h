@@ -32,6 +32,11 @@
 #include "statusUpdate.h"
 #include "polarMotorCoordinator.h"
 
+// How many steps are pulled from the current stepper at a time.  Position and status bookkeeping is done once per batch.
+#define STEP_BATCH_SIZE 32
+// Longest run of identical steps that will be merged into a single coordinator move
+#define MAX_COALESCED_STEPS 256
+
 class PolarPlotter
 {
 private:
@@ -43,7 +48,11 @@ private:
   WipeStepper wipeStepper;
   AbstractStepper *currentStepper;
   Step emptyStep;
-  Step pendingStep;
+  Step pendingSteps[STEP_BATCH_SIZE];
+  int pendingStepRuns[STEP_BATCH_SIZE];
+  unsigned long pendingStepIntervals[STEP_BATCH_SIZE];
+  int pendingStepIndex;
+  int pendingStepCount;
 
   PolarMotorCoordinator* coordinator;
   Point position;
@@ -52,18 +61,25 @@ private:
   double radiusStepSize;
   double azimuthStepSize;
   int marbleSizeInRadiusSteps;
+  // Linear speed of the current command in drawing units per second, or 0 to use the coordinator's fast/slow speeds
+  double feedRate;
 
+  bool applyStep(Step &step, unsigned long &interval);
+  void queueStep(Step &step, const unsigned long interval);
+  void flushPendingSteps(const bool includeLastRun);
   void printStep(const long radiusStep, const long azimuthStep, const bool fastStep, StatusUpdate* statusUpdater, ExtendedPrinter printer);
-  void updatePosition(const double newRadius, const double newAzimuth, Point &position, StatusUpdate* statusUpdater);
 
 public:
   PolarPlotter(Print &printer, StatusUpdate &statusUpdater, double maxRadius, int marbleSizeInRadiusSteps, PolarMotorCoordinator* coordinator);
   void calibrate(double initialRadius, double initialAzimuth, double radiusStepSize, double azimuthStepSize);
-  void startCommand(String &command);
+  void setLookahead(int depth, double maxDeviation);
+  void setSegmentTolerance(double tolerance);
+  void startCommand(const Command &command);
   bool hasNextStep();
   void clearStepper();
   void step();
-  void moveTo(const long radiusSteps, const long azimuthSteps, const bool fastStep);
+  bool canMove();
+  bool moveTo(const long radiusSteps, const long azimuthSteps, const bool fastStep);
   Point getPosition() const;
   static String getHelpMessage();
 };
@@ -27,12 +27,11 @@
 #include <iomanip>
 #endif
 
-bool SpiralStepper::parseArgumentsAndSetFinish(Point &currentPosition, String &arguments) {
-    int comma = arguments.indexOf(',');
-    if (comma <= 0) return false;
+bool SpiralStepper::parseArgumentsAndSetFinish(Point &currentPosition, const Command &command) {
+    if (command.getArgumentCount() < 2) return false;
 
-    double radiusOffset = arguments.substring(0, comma).toDouble();
-    double degreeOffset = arguments.substring(comma + 1).toDouble();
+    double radiusOffset = command.getArgument(0);
+    double degreeOffset = command.getArgument(1);
     double azimuthOffset = (degreeOffset / 180) * PI;
 
     if ((currentPosition.getRadius() + radiusOffset) < 0) {
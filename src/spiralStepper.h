@@ -34,7 +34,7 @@ private:
     bool stepped;
 
 protected:
-    bool parseArgumentsAndSetFinish(Point &currentPosition, String &arguments);
+    bool parseArgumentsAndSetFinish(Point &currentPosition, const Command &command);
     double findDistanceFromPointOnLineToFinish(Point &point);
     void setClosestPointOnLine(Point &point, Point &closestPoint);
     double determineStartingAzimuthFromCenter();
@@ -26,11 +26,14 @@
 
 #ifndef __IN_TEST__
 #include <Arduino.h>
-#include "pico/time.h"
 #else
 #include "mockArduino.h"
 #endif
 
+// Defaults for the common driver chips, which want at least a couple of microseconds on each
+#define DEFAULT_PULSE_WIDTH 20
+#define DEFAULT_DIRECTION_SETUP_TIME 20
+
 class StepDirMotor
 {
 protected:
@@ -45,6 +48,15 @@ protected:
     unsigned long nextStepTime;
     unsigned long nextStepTimeDelta;
 
+    // Step pulses and direction changes are never waited out.  The step pin is raised by step() and dropped by a later
+    // call to service() once the pulse width has passed, and after a direction change isReady() holds off the next
+    // step until the driver has had its setup time.
+    unsigned long pulseWidth = DEFAULT_PULSE_WIDTH;
+    unsigned long directionSetupTime = DEFAULT_DIRECTION_SETUP_TIME;
+    bool pulsing = false;
+    unsigned long pulseEndTime = 0;
+    unsigned long directionReadyTime = 0;
+
     virtual void initDriver() { }
     virtual void beginDriver() { }
 
@@ -62,11 +74,22 @@ public:
 
     virtual void begin()
     {
+        pulsing = false;
         digitalWrite(stepPin, LOW);
         digitalWrite(dirPin, LOW);
         this->beginDriver();
     }
 
+    virtual void setPulseWidth(const unsigned long micros)
+    {
+        pulseWidth = micros;
+    }
+
+    virtual void setDirectionSetupTime(const unsigned long micros)
+    {
+        directionSetupTime = micros;
+    }
+
     virtual void setupMove(const int steps, const unsigned long currentMicros, const unsigned long stepTimeDelta)
     {
         currentStep = 0;
@@ -78,10 +101,74 @@ public:
         {
             reversed = steps < 0;
             digitalWrite(dirPin, reversed ? HIGH : LOW);
-            sleep_us(20);
+            directionReadyTime = currentMicros + directionSetupTime;
         }
     }
 
+    // Returns true once the direction pin has been stable for the setup time
+    virtual bool isReady(const unsigned long currentMicros)
+    {
+        return (long)(currentMicros - directionReadyTime) >= 0;
+    }
+
+    virtual unsigned long getDirectionReadyTime()
+    {
+        return directionReadyTime;
+    }
+
+    virtual bool isPulsing()
+    {
+        return pulsing;
+    }
+
+    virtual unsigned long getPulseEndTime()
+    {
+        return pulseEndTime;
+    }
+
+    // Returns the bit for this motor's step pin, for writing it along with other pins in one masked write
+    virtual unsigned long getStepMask()
+    {
+        return 1ul << stepPin;
+    }
+
+    // Counts the next step and starts its pulse, returning the step pin's bit for the caller to raise, or 0 if the
+    // move is already done
+    virtual unsigned long beginStep(const unsigned long currentMicros)
+    {
+        if (!canMove())
+            return 0;
+
+        currentStep++;
+        position += (reversed ? -1 : 1);
+        pulsing = true;
+        pulseEndTime = currentMicros + pulseWidth;
+        return getStepMask();
+    }
+
+    // Ends the current pulse, returning the step pin's bit for the caller to drop, or 0 if there is no pulse
+    virtual unsigned long takePulse()
+    {
+        if (!pulsing)
+            return 0;
+
+        pulsing = false;
+        return getStepMask();
+    }
+
+    // As takePulse(), but only once the pulse width has passed
+    virtual unsigned long takeFinishedPulse(const unsigned long currentMicros)
+    {
+        return pulsing && (long)(currentMicros - pulseEndTime) >= 0 ? takePulse() : 0;
+    }
+
+    // Drops the step pin once the pulse width has passed
+    virtual void service(const unsigned long currentMicros)
+    {
+        if (takeFinishedPulse(currentMicros))
+            digitalWrite(stepPin, LOW);
+    }
+
     virtual bool canMove()
     {
         return currentStep < maxSteps;
@@ -89,16 +176,26 @@ public:
 
     virtual void move(const unsigned long currentMicros)
     {
-        if (!canMove() || currentMicros < nextStepTime)
+        service(currentMicros);
+        if (!canMove() || currentMicros < nextStepTime || !isReady(currentMicros))
             return;
 
         nextStepTime += nextStepTimeDelta;
-        currentStep++;
-        position += (reversed ? -1 : 1);
+        this->step(currentMicros);
+    }
 
-        digitalWrite(stepPin, HIGH);
-        sleep_us(20);
-        digitalWrite(stepPin, LOW);
+    // Takes the next step of the current move right away, leaving the timing to the caller.  The step pin is left high
+    // until a service() call at or after getPulseEndTime().
+    virtual void step(const unsigned long currentMicros)
+    {
+        if (!canMove())
+            return;
+
+        // A step interval shorter than the pulse width still gets an edge, by cutting the last pulse short
+        if (takePulse())
+            digitalWrite(stepPin, LOW);
+        if (beginStep(currentMicros))
+            digitalWrite(stepPin, HIGH);
     }
 
     virtual void declareOrigin()
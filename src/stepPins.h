@@ -0,0 +1,39 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_STEPPINS_H_
+#define _POLARPLOTTERCORE_STEPPINS_H_
+
+// Writes several step pins at once.  Each pin is one bit of the mask (1 << pin number), so the coordinator can raise,
+// and later drop, the pulses of both axes with a single write each, with their edges lined up.
+class StepPins
+{
+public:
+    /** Drives every pin whose bit is set in the mask high, leaving the others alone. */
+    virtual void set(const unsigned long mask) = 0;
+
+    /** Drives every pin whose bit is set in the mask low, leaving the others alone. */
+    virtual void clear(const unsigned long mask) = 0;
+};
+
+#endif
@@ -0,0 +1,204 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_STEPQUEUE_H_
+#define _POLARPLOTTERCORE_STEPQUEUE_H_
+
+#include <atomic>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+
+#define PACKED_STEP_FAST 0x8000
+#define PACKED_STEP_INTERVAL_MASK 0x7fff
+
+// Planned speeds are in whole steps per second, squared, of whichever axis moves the most in a step, so they fit an
+// unsigned long (32 bits) up to 65535 steps per second
+#define MAX_PLANNED_SPEED 65535UL
+
+// A queued step at full width, two longs, the speed flag, the step interval set by a feed rate (0 for none), the
+// fastest this step may be entered (from the change of direction at the junction with the step before it), and the
+// speed the planner has worked out it can be entered at, which is rewritten as more steps are queued behind it
+class QueuedStep
+{
+private:
+    long radiusStep;
+    long azimuthStep;
+    bool fast;
+    unsigned long interval;
+    unsigned long maxEntrySpeedSquared;
+    std::atomic<unsigned long> plannedEntrySpeedSquared;
+
+public:
+    // The largest step, on either axis, that can be stored in one slot
+    static const long MAX_DELTA = LONG_MAX;
+
+    void setStep(const long radiusStep, const long azimuthStep, const bool fast, const unsigned long interval)
+    {
+        this->radiusStep = radiusStep;
+        this->azimuthStep = azimuthStep;
+        this->fast = fast;
+        this->interval = interval;
+    }
+
+    long getRadiusStep() const { return radiusStep; }
+    long getAzimuthStep() const { return azimuthStep; }
+    bool isFast() const { return fast; }
+    unsigned long getInterval() const { return interval; }
+
+    // No move is queued that steps neither axis, so an empty step marks where an origin was declared
+    bool isOrigin() const { return radiusStep == 0 && azimuthStep == 0; }
+
+    void setMaxEntrySpeedSquared(const unsigned long speedSquared) { maxEntrySpeedSquared = speedSquared; }
+    unsigned long getMaxEntrySpeedSquared() const { return maxEntrySpeedSquared; }
+
+    void setPlannedEntrySpeedSquared(const unsigned long speedSquared) { plannedEntrySpeedSquared.store(speedSquared, std::memory_order_relaxed); }
+    unsigned long getPlannedEntrySpeedSquared() const { return plannedEntrySpeedSquared.load(std::memory_order_relaxed); }
+};
+
+// A queued step in 10 bytes, 16 bit signed deltas, the maximum and planned entry speeds in whole steps per second, and
+// the speed flag sharing a word with a feed rate interval of up to 32767us.  The speeds are rounded down, so the planner
+// only ever gets more cautious.
+class PackedQueuedStep
+{
+private:
+    int16_t radiusStep;
+    int16_t azimuthStep;
+    uint16_t maxEntrySpeed;
+    uint16_t flagsAndInterval;
+    std::atomic<uint16_t> plannedEntrySpeed;
+
+    static uint16_t toSpeed(const unsigned long speedSquared)
+    {
+        unsigned long speed = sqrt((double)speedSquared);
+        return speed >= MAX_PLANNED_SPEED ? MAX_PLANNED_SPEED : speed;
+    }
+
+public:
+    static const long MAX_DELTA = INT16_MAX;
+
+    void setStep(const long radiusStep, const long azimuthStep, const bool fast, const unsigned long interval)
+    {
+        this->radiusStep = (int16_t)radiusStep;
+        this->azimuthStep = (int16_t)azimuthStep;
+        flagsAndInterval = (fast ? PACKED_STEP_FAST : 0) | (interval > PACKED_STEP_INTERVAL_MASK ? PACKED_STEP_INTERVAL_MASK : interval);
+    }
+
+    long getRadiusStep() const { return radiusStep; }
+    long getAzimuthStep() const { return azimuthStep; }
+    bool isFast() const { return (flagsAndInterval & PACKED_STEP_FAST) != 0; }
+    unsigned long getInterval() const { return flagsAndInterval & PACKED_STEP_INTERVAL_MASK; }
+    bool isOrigin() const { return radiusStep == 0 && azimuthStep == 0; }
+
+    void setMaxEntrySpeedSquared(const unsigned long speedSquared) { maxEntrySpeed = toSpeed(speedSquared); }
+    unsigned long getMaxEntrySpeedSquared() const { return (unsigned long)maxEntrySpeed * maxEntrySpeed; }
+
+    void setPlannedEntrySpeedSquared(const unsigned long speedSquared) { plannedEntrySpeed.store(toSpeed(speedSquared), std::memory_order_relaxed); }
+    unsigned long getPlannedEntrySpeedSquared() const
+    {
+        unsigned long speed = plannedEntrySpeed.load(std::memory_order_relaxed);
+        return speed * speed;
+    }
+};
+
+// Lock-free ring of Capacity - 1 steps, stored as Storage (QueuedStep or PackedQueuedStep), with a single producer
+// (the planner) and a single consumer (the motors).  Only the producer writes the tail and only the consumer writes
+// the head.  Each side publishes its index with a release store and reads the other's with an acquire load, so a
+// slot's contents are visible before the index that hands it over, and a slot is never refilled before the consumer
+// has finished with it.  One slot always stays empty to tell full from empty.
+template <int Capacity, class Storage>
+class StepQueue
+{
+private:
+    Storage slots[Capacity];
+    std::atomic<int> head;
+    std::atomic<int> tail;
+
+    // The most steps ever waiting at once, kept by the producer as it pushes
+    std::atomic<int> highWaterMark;
+
+public:
+    StepQueue() : head(0), tail(0), highWaterMark(0) { }
+
+    static int getCapacity() { return Capacity - 1; }
+    static int getNextIndex(const int index) { return (index + 1) % Capacity; }
+
+    /** Producer: returns true if there is no room for another step. */
+    bool isFull() const { return getNextIndex(tail.load(std::memory_order_relaxed)) == head.load(std::memory_order_acquire); }
+
+    /** Producer: the number of steps that can be pushed before the queue is full. */
+    int getFreeCount() const { return Capacity - 1 - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) + Capacity) % Capacity; }
+
+    /** Producer: the slot the next step is written to, which is not visible to the consumer until push(). */
+    Storage &back() { return slots[tail.load(std::memory_order_relaxed)]; }
+
+    /**
+     * Either side: the slot at the given index.  Once pushed, a slot's contents belong to the consumer, apart from
+     * fields made to be shared, such as a step's planned entry speed.
+     */
+    Storage &at(const int index) { return slots[index]; }
+
+    /** Producer: hands the slot filled through back() to the consumer. */
+    void push()
+    {
+        int next = getNextIndex(tail.load(std::memory_order_relaxed));
+        tail.store(next, std::memory_order_release);
+
+        int waiting = (next - head.load(std::memory_order_acquire) + Capacity) % Capacity;
+        if (waiting > highWaterMark.load(std::memory_order_relaxed))
+            highWaterMark.store(waiting, std::memory_order_relaxed);
+    }
+
+    /** Either side: returns true if there are no steps waiting. */
+    bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    /** Consumer: the number of steps waiting. */
+    int count() const { return (tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed) + Capacity) % Capacity; }
+
+    /** Consumer: the step offset places from the front, where offset is less than count(). */
+    Storage &peek(const int offset) { return slots[(head.load(std::memory_order_relaxed) + offset) % Capacity]; }
+
+    /** Consumer: releases the front step back to the producer, once it has been copied out. */
+    void pop() { head.store(getNextIndex(head.load(std::memory_order_relaxed)), std::memory_order_release); }
+
+    /** Consumer: drops every step waiting ahead of the given slot index. */
+    void dropUntil(const int index)
+    {
+        while (!isEmpty() && head.load(std::memory_order_relaxed) != index) pop();
+    }
+
+    /** The slot index the next pushed step will use (producer), or that the next popped step comes from (consumer). */
+    int getTailIndex() const { return tail.load(std::memory_order_acquire); }
+    int getHeadIndex() const { return head.load(std::memory_order_acquire); }
+
+    /** The slot index offset places after the given one. */
+    static int offsetIndex(const int index, const int offset) { return (index + offset) % Capacity; }
+
+    /** The slot index just before the given one. */
+    static int getPreviousIndex(const int index) { return (index + Capacity - 1) % Capacity; }
+
+    int getHighWaterMark() const { return highWaterMark.load(std::memory_order_relaxed); }
+    void resetHighWaterMark() { highWaterMark.store(0, std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*
+    This file is part of the PolarPlotterCore library.
+    Copyright (c) 2024 Benjamin Carleski
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _POLARPLOTTERCORE_STEPTIMER_H_
+#define _POLARPLOTTERCORE_STEPTIMER_H_
+
+// A one-shot hardware alarm.  The coordinator re-arms it for the time of each next step, so pulses come from the alarm
+// callback on time no matter what the foreground loop is doing.
+class StepTimer
+{
+public:
+    typedef void (*Callback)(void *context);
+
+    /** Returns the current time in microseconds, on the same clock the alarm uses. */
+    virtual unsigned long now() = 0;
+
+    /** Arms the alarm to call callback(context) once at the given time, or as soon as possible if that has already passed.  Replaces any alarm already armed. */
+    virtual void schedule(const unsigned long atMicros, Callback callback, void *context) = 0;
+
+    /** Disarms the alarm. */
+    virtual void cancel() = 0;
+};
+
+#endif
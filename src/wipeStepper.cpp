@@ -32,7 +32,7 @@ WipeStepper::WipeStepper(double maxRadius) : currentStep(Step()), state(WIPE_INI
 {
 }
 
-void WipeStepper::startNewLine(Point &currentPosition, String &arguments)
+void WipeStepper::startNewLine(Point &currentPosition, const Command &command)
 {
     state = MOVING_TO_EDGE;
     stepsToEdge = round((maxRadius - currentPosition.getRadius()) / radiusStepSize);
@@ -73,6 +73,18 @@ Step &WipeStepper::step()
     return currentStep;
 }
 
+size_t WipeStepper::fillSteps(Step *steps, size_t capacity)
+{
+    size_t count = 0;
+
+    while (count < capacity && WipeStepper::hasStep()) {
+        Step &next = WipeStepper::step();
+        steps[count++].setStepsWithSpeed(next.getRadiusStep(), next.getAzimuthStep(), true);
+    }
+
+    return count;
+}
+
 void WipeStepper::calibrate(double radiusStepSize, double azimuthStepSize)
 {
     this->radiusStepSize = radiusStepSize;
@@ -56,9 +56,10 @@ private:
 public:
     WipeStepper(double maxRadius);
     void calibrate(double radiusStepSize, double azimuthStepSize);
-    void startNewLine(Point &currentPosition, String &arguments);
+    void startNewLine(Point &currentPosition, const Command &command);
     bool hasStep();
     Step& step();
+    size_t fillSteps(Step *steps, size_t capacity);
     bool isFastStep() { return true; }
 };
 
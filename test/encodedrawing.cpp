@@ -0,0 +1,70 @@
+#ifndef __IN_TEST__
+#define __IN_TEST__
+#endif
+#include "drawingFormat.h"
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_LENGTH 256
+
+using namespace std;
+
+// Converts a text drawing, one command a line, into the binary drawing format
+int main(int argc, char **argv) {
+    if (argc != 3 && argc != 4 && argc != 6) {
+        cerr << "Usage: " << argv[0] << " input.txt output.ppd [decimals [maxRadiusSteps fullCircleAzimuthSteps]]\n";
+        return 2;
+    }
+
+    FILE *input = fopen(argv[1], "r");
+    if (!input) {
+        cerr << "Unable to open " << argv[1] << "\n";
+        return 1;
+    }
+    FILE *output = fopen(argv[2], "wb");
+    if (!output) {
+        cerr << "Unable to create " << argv[2] << "\n";
+        fclose(input);
+        return 1;
+    }
+
+    DrawingEncoder encoder(argc >= 4 ? atoi(argv[3]) : DRAWING_DEFAULT_DECIMALS);
+    uint8_t buffer[DRAWING_MAX_HEADER_LENGTH > DRAWING_MAX_COMMAND_LENGTH ? DRAWING_MAX_HEADER_LENGTH : DRAWING_MAX_COMMAND_LENGTH];
+    long textBytes = 0;
+    long binaryBytes = 0;
+    long commands = 0;
+    long skipped = 0;
+    long lineNumber = 0;
+
+    int length = encoder.encodeHeader(buffer, argc == 6 ? atol(argv[4]) : 0, argc == 6 ? atol(argv[5]) : 0);
+    fwrite(buffer, 1, length, output);
+    binaryBytes += length;
+
+    char line[LINE_LENGTH];
+    while (fgets(line, LINE_LENGTH, input)) {
+        lineNumber++;
+        textBytes += strlen(line);
+
+        Command command;
+        CommandError error = command.parse(line);
+        if (error == COMMAND_EMPTY) continue;
+
+        length = error == COMMAND_OK ? encoder.encodeCommand(buffer, command) : 0;
+        if (length == 0) {
+            cerr << "Line " << lineNumber << ": skipping, " << (error == COMMAND_OK ? encoder.getError() : Command::describeError(error)) << "\n";
+            skipped++;
+            continue;
+        }
+
+        fwrite(buffer, 1, length, output);
+        binaryBytes += length;
+        commands++;
+    }
+
+    fclose(input);
+    fclose(output);
+    cout << "Encoded " << commands << " commands (" << skipped << " skipped), " << textBytes << " bytes of text to " << binaryBytes << " bytes\n";
+    return skipped > 0 ? 1 : 0;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <cstdint>
+#include <cstring>
 #include "fakeString.h"
 #define DEC 10
 
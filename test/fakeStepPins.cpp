@@ -0,0 +1,44 @@
+#include "fakeStepPins.h"
+
+FakeStepPins::FakeStepPins()
+  : state(0),
+    writeCount(0)
+{
+}
+
+void FakeStepPins::set(const unsigned long mask) {
+  writeCount++;
+  unsigned long changed = mask & ~state;
+  state |= mask;
+  if (changed != 0) {
+    Transition transition = { changed, true };
+    transitions.push_back(transition);
+  }
+}
+
+void FakeStepPins::clear(const unsigned long mask) {
+  writeCount++;
+  unsigned long changed = mask & state;
+  state &= ~mask;
+  if (changed != 0) {
+    Transition transition = { changed, false };
+    transitions.push_back(transition);
+  }
+}
+
+unsigned long FakeStepPins::countRisingEdges(const int pin) const {
+  unsigned long count = 0;
+  for (unsigned long i = 0; i < transitions.size(); i++) {
+    if (transitions[i].high && (transitions[i].mask & (1ul << pin)) != 0) count++;
+  }
+  return count;
+}
+
+unsigned long FakeStepPins::countAlignedRisingEdges(const int pin, const int otherPin) const {
+  unsigned long both = (1ul << pin) | (1ul << otherPin);
+  unsigned long count = 0;
+  for (unsigned long i = 0; i < transitions.size(); i++) {
+    if (transitions[i].high && (transitions[i].mask & both) == both) count++;
+  }
+  return count;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "stepPins.h"
+#include <vector>
+
+// A StepPins that keeps the pin levels in memory, and records every write that changed any of them
+class FakeStepPins : public StepPins {
+public:
+  struct Transition {
+    unsigned long mask;
+    bool high;
+  };
+
+private:
+  unsigned long state;
+  unsigned long writeCount;
+  std::vector<Transition> transitions;
+
+public:
+  FakeStepPins();
+  void set(const unsigned long mask);
+  void clear(const unsigned long mask);
+
+  unsigned long getState() const { return state; }
+  unsigned long getWriteCount() const { return writeCount; }
+  const std::vector<Transition> &getTransitions() const { return transitions; }
+
+  // Counts the rising edges of the given pin, and how many of them came in the same write as the other pin's
+  unsigned long countRisingEdges(const int pin) const;
+  unsigned long countAlignedRisingEdges(const int pin, const int otherPin) const;
+};
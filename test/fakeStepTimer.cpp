@@ -0,0 +1,39 @@
+#include "fakeStepTimer.h"
+
+FakeStepTimer::FakeStepTimer()
+  : currentMicros(0),
+    alarmMicros(0),
+    alarmCount(0),
+    armed(false),
+    callback(0),
+    context(0)
+{
+}
+
+unsigned long FakeStepTimer::now() {
+  return currentMicros;
+}
+
+void FakeStepTimer::schedule(const unsigned long atMicros, Callback callback, void *context) {
+  this->alarmMicros = atMicros;
+  this->callback = callback;
+  this->context = context;
+  this->armed = true;
+}
+
+void FakeStepTimer::cancel() {
+  armed = false;
+}
+
+void FakeStepTimer::advance(const unsigned long micros) {
+  unsigned long end = currentMicros + micros;
+
+  while (armed && (long)(alarmMicros - end) <= 0) {
+    if ((long)(alarmMicros - currentMicros) > 0) currentMicros = alarmMicros;
+    armed = false;
+    alarmCount++;
+    callback(context);
+  }
+
+  currentMicros = end;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "stepTimer.h"
+
+// A StepTimer on simulated time, which only moves when advance() is called
+class FakeStepTimer : public StepTimer {
+private:
+  unsigned long currentMicros;
+  unsigned long alarmMicros;
+  unsigned long alarmCount;
+  bool armed;
+  Callback callback;
+  void *context;
+
+public:
+  FakeStepTimer();
+  unsigned long now();
+  void schedule(const unsigned long atMicros, Callback callback, void *context);
+  void cancel();
+
+  // Moves time forward, firing the alarm every time it comes due along the way
+  void advance(const unsigned long micros);
+  unsigned long getAlarmCount() const { return alarmCount; }
+};
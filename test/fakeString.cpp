@@ -1,11 +1,24 @@
 #include "fakeString.h"
 #include <string>
 #include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static size_t copyString(char *dst, const char *src, size_t size)
+{
+  size_t srcLength = strlen(src);
+  if (size > 0) {
+    size_t count = srcLength < size - 1 ? srcLength : size - 1;
+    memcpy(dst, src, count);
+    dst[count] = '\0';
+  }
+  return srcLength;
+}
 
 String::String(const char *cstr)
   : length(strlen(cstr))
 {
-  strlcpy(this->cstr, cstr, length + 1);
+  copyString(this->cstr, cstr, length + 1);
 }
 
 String::String(const long val)
@@ -14,29 +27,34 @@ String::String(const long val)
 {
 }
 
+String::String(const double val, const unsigned char decimalPlaces)
+{
+  length = snprintf(cstr, sizeof(cstr), "%.*f", decimalPlaces, val);
+}
+
 String::String(const String &rval)
   : length(rval.length)
 {
-  strlcpy(cstr, rval.cstr, rval.length + 1);
+  copyString(cstr, rval.cstr, rval.length + 1);
 }
 
 String::String(String &rval)
   : length(rval.length)
 {
-  strlcpy(cstr, rval.cstr, rval.length + 1);
+  copyString(cstr, rval.cstr, rval.length + 1);
 }
 
 String & String::operator = (const String &rhs)
 {
   length = rhs.length;
-  strlcpy(cstr, rhs.cstr, length + 1);
+  copyString(cstr, rhs.cstr, length + 1);
 	return *this;
 }
 
 String & String::operator = (const char *cstr)
 {
   length = strlen(cstr);
-  strlcpy(this->cstr, cstr, length + 1);
+  copyString(this->cstr, cstr, length + 1);
 	return *this;
 }
 
@@ -50,17 +68,17 @@ char String::charAt(unsigned int index) const {
 
 int String::indexOf(char c) const {
   const char *pch = strchr(cstr, c);
-  return pch - cstr;
+  return pch != NULL ? pch - cstr : -1;
 }
 
 int String::indexOf(char ch, unsigned int fromIndex) const {
   const char *pch = strchr(cstr + fromIndex, ch);
-  return pch - cstr;
+  return pch != NULL ? pch - cstr : -1;
 }
 
 String String::substring( unsigned int beginIndex, unsigned int endIndex ) const {
   char substr[1024];
-  strlcpy(substr, cstr + beginIndex, endIndex - beginIndex + 1);
+  copyString(substr, cstr + beginIndex, endIndex - beginIndex + 1);
 
   String newString(substr);
 	return newString;
@@ -10,6 +10,7 @@ private:
 public:
     String(const char *cstr = "");
     String(const long val);
+    String(const double val, const unsigned char decimalPlaces);
     String(const String &rval);
     String(String &rval);
 
@@ -25,6 +26,16 @@ public:
 	String & operator + (unsigned long num)	{return (*this);}
 	String & operator + (float num)		    {return (*this);}
 	String & operator + (double num)		{return (*this);}
+	String & operator += (const String &rhs)	{return (*this);}
+	String & operator += (const char *cstr)	{return (*this);}
+	String & operator += (char c)			{return (*this);}
+	String & operator += (unsigned char num)	{return (*this);}
+	String & operator += (int num)			{return (*this);}
+	String & operator += (unsigned int num)	{return (*this);}
+	String & operator += (long num)			{return (*this);}
+	String & operator += (unsigned long num)	{return (*this);}
+	String & operator += (float num)		{return (*this);}
+	String & operator += (double num)		{return (*this);}
 
     const char* c_str() const;
     char charAt(unsigned int index) const;
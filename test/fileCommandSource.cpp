@@ -0,0 +1,63 @@
+#include "fileCommandSource.h"
+#include <string.h>
+
+FileCommandSource::FileCommandSource(const char *path)
+    : file(fopen(path, "r")),
+      hasPending(false),
+      lineNumber(0),
+      lineCount(0),
+      errorCount(0)
+{
+}
+
+FileCommandSource::~FileCommandSource()
+{
+  if (file) fclose(file);
+}
+
+void FileCommandSource::readLine()
+{
+  while (!hasPending && file && fgets(line, FILE_COMMAND_LENGTH, file)) {
+    size_t length = strlen(line);
+    lineNumber++;
+
+    // Drop the rest of a line too long for the buffer
+    if (length == 0 || line[length - 1] != '\n') {
+      int chr;
+      while ((chr = fgetc(file)) != EOF && chr != '\n');
+    }
+
+    CommandError error = pending.parse(line);
+    if (error == COMMAND_OK) {
+      hasPending = true;
+    } else if (error != COMMAND_EMPTY) {
+      fprintf(stderr, "Line %ld: %s\n", lineNumber, Command::describeError(error));
+      errorCount++;
+    }
+  }
+}
+
+bool FileCommandSource::hasCommand()
+{
+  readLine();
+  return hasPending;
+}
+
+bool FileCommandSource::nextCommand(Command &command)
+{
+  if (!hasCommand()) return false;
+
+  command = pending;
+  hasPending = false;
+  lineCount++;
+  return true;
+}
+
+void FileCommandSource::clear()
+{
+  hasPending = false;
+  if (file) {
+    fclose(file);
+    file = NULL;
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "commandSource.h"
+#include <stdio.h>
+
+#define FILE_COMMAND_LENGTH 256
+
+// Streams commands from a text file, one a line, reading and parsing a line only when the controller asks for it, so a
+// drawing of any size is held one command at a time.  Blank lines are skipped, and so are lines that fail to parse,
+// which are reported on stderr.
+class FileCommandSource : public CommandSource
+{
+private:
+  FILE *file;
+  char line[FILE_COMMAND_LENGTH];
+  Command pending;
+  bool hasPending;
+  long lineNumber;
+  long lineCount;
+  long errorCount;
+
+  void readLine();
+
+public:
+  FileCommandSource(const char *path);
+  ~FileCommandSource();
+
+  bool isOpen() const { return file != NULL; }
+  long getLineCount() const { return lineCount; }
+  long getErrorCount() const { return errorCount; }
+
+  bool hasCommand();
+  bool nextCommand(Command &command);
+  void clear();
+};
@@ -8,11 +8,26 @@ unsigned long millis() {
   return (t_now.time  - t_start.time) * 1000 + (t_now.millitm - t_start.millitm);
 }
 
+unsigned long micros() {
+  timeb t_now;
+  ftime(&t_now);
+  return ((t_now.time  - t_start.time) * 1000 + (t_now.millitm - t_start.millitm)) * 1000;
+}
+
 void delay(unsigned long ms) {
   unsigned long start = millis();
   while(millis() - start < ms){}
 }
 
+void sleep_us(unsigned long micros) {
+}
+
+void pinMode(int pin, int mode) {
+}
+
+void digitalWrite(int pin, int value) {
+}
+
 void initialize_mock_arduino() {
   ftime(&t_start);
 }
\ No newline at end of file
@@ -1,14 +1,25 @@
 #pragma once
 
+#include <math.h>
+#include <stdlib.h>
+
 typedef unsigned char byte;
 #define PI          3.1415926535897932384626433832795
 #define __SHOW_STEP__
 //#define __SHOW_STEP_DETAILS__
 
 
+#define HIGH        0x1
+#define LOW         0x0
+#define INPUT       0x0
+#define OUTPUT      0x1
+
 unsigned long millis();
+unsigned long micros();
 void delay(unsigned long ms);
 void sleep_us(unsigned long micros);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
 
 void initialize_mock_arduino(); 
 
@@ -0,0 +1,440 @@
+#ifndef __IN_TEST__
+#define __IN_TEST__
+#endif
+#include "lineStepper.h"
+#include "circleStepper.h"
+#include "spiralStepper.h"
+#include "polarMotorCoordinator.h"
+#include "fakeStepTimer.h"
+#include "drawingFormat.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define MAX_RADIUS 1000
+#define MAX_RADIUS_STEPS 10500
+#define FULL_CIRCLE_AZIMUTH_STEPS 4810
+#define COORDINATOR_MOVES 200000
+#define MOVE_SETUPS 2000000
+#define CONSUMER_MOVES 200000
+#define BENCHMARK_ACCELERATION 20000.0
+#define PARSE_COMMANDS 100000
+
+const double maxRadius = MAX_RADIUS;
+const double radiusStepSize = maxRadius / MAX_RADIUS_STEPS;
+const double azimuthStepSize = (2 * PI) / FULL_CIRCLE_AZIMUTH_STEPS;
+
+using namespace std;
+
+struct BenchmarkResult {
+    unsigned long steps;
+    unsigned long cartesianConversions;
+    unsigned long polarConversions;
+    double elapsedMicros;
+};
+
+BenchmarkResult runStepper(BaseStepper &stepper, const char *commands[], int commandCount) {
+    Point position(100, 0);
+    BenchmarkResult result = { 0, 0, 0, 0 };
+
+    stepper.calibrate(radiusStepSize, azimuthStepSize);
+    Point::cartesianConversions = 0;
+    Point::polarConversions = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < commandCount; i++) {
+        Command command;
+        command.parse(commands[i]);
+        stepper.startNewLine(position, command);
+
+        while (stepper.hasStep()) {
+            Step &step = stepper.step();
+            position.repoint(position.getRadius() + step.getRadiusStep() * radiusStepSize,
+                             position.getAzimuth() + step.getAzimuthStep() * azimuthStepSize);
+            result.steps++;
+        }
+    }
+    auto finish = chrono::steady_clock::now();
+
+    result.cartesianConversions = Point::cartesianConversions;
+    result.polarConversions = Point::polarConversions;
+    result.elapsedMicros = chrono::duration<double, micro>(finish - start).count();
+    return result;
+}
+
+BenchmarkResult runSegments(BaseStepper &stepper, const char *commands[], int commandCount) {
+    Point position(100, 0);
+    BenchmarkResult result = { 0, 0, 0, 0 };
+    Step steps[32];
+
+    stepper.calibrate(radiusStepSize, azimuthStepSize);
+    Point::cartesianConversions = 0;
+    Point::polarConversions = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < commandCount; i++) {
+        Command command;
+        command.parse(commands[i]);
+        stepper.startNewLine(position, command);
+
+        size_t count;
+        while ((count = stepper.fillSteps(steps, 32)) > 0) {
+            for (size_t j = 0; j < count; j++) {
+                position.repoint(position.getRadius() + steps[j].getRadiusStep() * radiusStepSize,
+                                 position.getAzimuth() + steps[j].getAzimuthStep() * azimuthStepSize);
+            }
+            result.steps += count;
+        }
+    }
+    auto finish = chrono::steady_clock::now();
+
+    result.cartesianConversions = Point::cartesianConversions;
+    result.polarConversions = Point::polarConversions;
+    result.elapsedMicros = chrono::duration<double, micro>(finish - start).count();
+    return result;
+}
+
+// Exposes the coordinator's move setup, so it can be timed on its own
+class BenchmarkCoordinator : public PolarMotorCoordinator {
+public:
+    BenchmarkCoordinator(StepDirMotor *radius, StepDirMotor *azimuth)
+        : PolarMotorCoordinator(radius, azimuth, 0, 200, 2000, 1.5) { }
+    using PolarMotorCoordinator::setupMove;
+    using PolarMotorCoordinator::service;
+};
+
+// Sets up a move for each unit step of a typical drawing, alternating fast and slow
+BenchmarkResult runMoveSetup() {
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    BenchmarkCoordinator coordinator(&radiusMotor, &azimuthMotor);
+    FakeStepTimer timer;
+    BenchmarkResult result = { 0, 0, 0, 0 };
+
+    coordinator.attachTimer(&timer);
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < MOVE_SETUPS; i++) {
+        if (coordinator.setupMove((i % 3) - 1, ((i / 3) % 3) - 1, (i & 1) != 0, 0, timer.now())) result.steps++;
+    }
+    auto finish = chrono::steady_clock::now();
+
+    result.elapsedMicros = chrono::duration<double, micro>(finish - start).count();
+    return result;
+}
+
+// The way moves were set up before, with the interval worked out in doubles for every move, kept as the baseline to
+// compare with
+class FloatMoveSetup {
+private:
+    StepDirMotor *radius;
+    StepDirMotor *azimuth;
+    StepDirMotor *majorMotor = NULL;
+    StepDirMotor *minorMotor = NULL;
+    unsigned long minimumInterval = 200;
+    unsigned long maximumInterval = 2000;
+    unsigned long stepInterval = 200;
+    double slowSpeedIntervalMultiplier = 1.5;
+    unsigned long majorInterval = 0;
+    unsigned long nextStepTime = 0;
+    long majorSteps = 0;
+    long minorSteps = 0;
+    long majorProgress = 0;
+    long minorError = 0;
+
+    double getMoveInterval(const bool fastStep, const unsigned long interval) {
+        if (interval > 0)
+            return interval > maximumInterval ? maximumInterval : interval < minimumInterval ? minimumInterval : interval;
+
+        return stepInterval * (fastStep ? 1 : slowSpeedIntervalMultiplier);
+    }
+
+public:
+    FloatMoveSetup(StepDirMotor *radius, StepDirMotor *azimuth) : radius(radius), azimuth(azimuth) { }
+
+    // Kept out of line, as the coordinator's is, so the loop around it can't be folded into it
+    __attribute__((noinline)) bool setupMove(const long nextRadiusSteps, const long nextAzimuthSteps, const bool fastStep, const unsigned long interval, const unsigned long currentMicros) {
+        long rSteps = abs(nextRadiusSteps);
+        long aSteps = abs(nextAzimuthSteps);
+        long maxSteps = rSteps > aSteps ? rSteps : aSteps;
+        if (maxSteps == 0) {
+            majorMotor = NULL;
+            return false;
+        }
+
+        majorInterval = round(getMoveInterval(fastStep, interval));
+        majorMotor = rSteps >= aSteps ? radius : azimuth;
+        minorMotor = rSteps >= aSteps ? azimuth : radius;
+        majorSteps = maxSteps;
+        minorSteps = rSteps >= aSteps ? aSteps : rSteps;
+        majorProgress = 0;
+        minorError = majorSteps / 2;
+
+        nextStepTime = currentMicros + majorInterval;
+        radius->setupMove(nextRadiusSteps, currentMicros, 0);
+        azimuth->setupMove(nextAzimuthSteps, currentMicros, 0);
+        if (!radius->isReady(nextStepTime))
+            nextStepTime = radius->getDirectionReadyTime();
+        if (!azimuth->isReady(nextStepTime))
+            nextStepTime = azimuth->getDirectionReadyTime();
+
+        return true;
+    }
+};
+
+// The same moves as runMoveSetup, set up the way they were before
+BenchmarkResult runFloatMoveSetup() {
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    FloatMoveSetup setup(&radiusMotor, &azimuthMotor);
+    FakeStepTimer timer;
+    BenchmarkResult result = { 0, 0, 0, 0 };
+
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < MOVE_SETUPS; i++) {
+        if (setup.setupMove((i % 3) - 1, ((i / 3) % 3) - 1, (i & 1) != 0, 0, timer.now())) result.steps++;
+    }
+    auto finish = chrono::steady_clock::now();
+
+    result.elapsedMicros = chrono::duration<double, micro>(finish - start).count();
+    return result;
+}
+
+// Times the motor side alone, one service() call a move, which is what the timer alarm runs: the step that is due,
+// then preparing and planning the next queued move.  The queue is topped up, untimed, whenever it is half empty, so
+// the planner always has a full queue ahead of it.  The steps run nearly straight, so the planned speeds stay high.
+BenchmarkResult runConsumer(const double acceleration) {
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    BenchmarkCoordinator coordinator(&radiusMotor, &azimuthMotor);
+    BenchmarkResult result = { 0, 0, 0, 0 };
+    const int batch = coordinator.getQueueCapacity() / 2;
+    unsigned long now = 0;
+    long queued = 0;
+
+    coordinator.setAcceleration(acceleration);
+    while (result.steps < CONSUMER_MOVES) {
+        while (coordinator.canAddSteps()) {
+            coordinator.addSteps(1, queued % 3 == 0 ? 1 : 0, true);
+            queued++;
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < batch; i++) {
+            now += 2000;
+            coordinator.service(now);
+        }
+        result.elapsedMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        result.steps += batch;
+    }
+
+    return result;
+}
+
+// Runs unit steps through the whole coordinator, from addSteps to the timer alarm that steps the motors
+BenchmarkResult runCoordinator(const double acceleration) {
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    BenchmarkCoordinator coordinator(&radiusMotor, &azimuthMotor);
+    FakeStepTimer timer;
+    BenchmarkResult result = { 0, 0, 0, 0 };
+
+    coordinator.setAcceleration(acceleration);
+    coordinator.attachTimer(&timer);
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < COORDINATOR_MOVES || coordinator.isMoving(); ) {
+        while (i < COORDINATOR_MOVES && coordinator.canAddSteps()) {
+            coordinator.addSteps((i % 3) - 1, ((i / 3) % 3) - 1, (i & 1) != 0);
+            i++;
+        }
+        timer.advance(10000);
+    }
+    auto finish = chrono::steady_clock::now();
+
+    result.steps = COORDINATOR_MOVES;
+    result.elapsedMicros = chrono::duration<double, micro>(finish - start).count();
+    return result;
+}
+
+// The way arguments were parsed before, a substring and toDouble for each one, kept as the baseline to compare with
+int parseWithStrings(const String &text, double *values, double &feedRate) {
+    String arguments = text.substring(1);
+    int count = 0;
+
+    feedRate = 0;
+    int feedIndex = arguments.indexOf('F');
+    if (feedIndex >= 0) {
+        feedRate = arguments.substring(feedIndex + 1).toDouble();
+        arguments = arguments.substring(0, feedIndex > 0 && arguments.charAt(feedIndex - 1) == ',' ? feedIndex - 1 : feedIndex);
+    }
+
+    int start = 0;
+    while (count < MAX_COMMAND_ARGUMENTS) {
+        int comma = arguments.indexOf(',', start);
+        values[count++] = (comma < 0 ? arguments.substring(start) : arguments.substring(start, comma)).toDouble();
+        if (comma < 0) break;
+        start = comma + 1;
+    }
+
+    return count;
+}
+
+// A drawing of lines, arcs and spirals, some with feed rates, written the way drawing tools write them
+vector<string> makeDrawing(int count) {
+    vector<string> drawing;
+    char text[64];
+
+    srand(1);
+    for (int i = 0; i < count; i++) {
+        double x = (rand() % 200000 - 100000) / 100.0;
+        double y = (rand() % 200000 - 100000) / 100.0;
+        double degrees = (rand() % 36000 - 18000) / 100.0;
+
+        switch (i % 4) {
+            case 0: case 1: snprintf(text, sizeof(text), "L%.2f,%.2f", x, y); break;
+            case 2: snprintf(text, sizeof(text), "C%.2f,%.2f,%.1f", x, y, degrees); break;
+            case 3: snprintf(text, sizeof(text), "S%.3f,%.2f,F%d", x / 10, degrees, 20 + rand() % 100); break;
+        }
+        drawing.push_back(text);
+    }
+
+    return drawing;
+}
+
+// Keeps the parsed values in use, so the parsing can't be optimized away
+volatile double parseSink;
+
+// Parses every command of the drawing both ways, checking they agree once the arguments are stored
+void runParsers() {
+    vector<string> drawing = makeDrawing(PARSE_COMMANDS);
+    vector<String> strings;
+    double totalBytes = 0;
+    for (size_t i = 0; i < drawing.size(); i++) {
+        strings.push_back(String(drawing[i].c_str()));
+        totalBytes += drawing[i].size();
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < strings.size(); i++) {
+        double values[MAX_COMMAND_ARGUMENTS];
+        double feedRate;
+        int count = parseWithStrings(strings[i], values, feedRate);
+        parseSink = values[count - 1] + feedRate;
+    }
+    double stringMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    long errors = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < drawing.size(); i++) {
+        Command command;
+        if (command.parse(drawing[i].c_str()) != COMMAND_OK) errors++;
+        parseSink = command.getArgument(command.getArgumentCount() - 1) + command.getFeedRate();
+    }
+    double parserMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    // The same drawing in the binary format, decoded a byte at a time as the controller does
+    DrawingEncoder encoder;
+    vector<uint8_t> binary(DRAWING_MAX_HEADER_LENGTH + drawing.size() * DRAWING_MAX_COMMAND_LENGTH);
+    size_t binaryLength = encoder.encodeHeader(binary.data(), MAX_RADIUS_STEPS, FULL_CIRCLE_AZIMUTH_STEPS);
+    for (size_t i = 0; i < drawing.size(); i++) {
+        Command command;
+        command.parse(drawing[i].c_str());
+        binaryLength += encoder.encodeCommand(&binary[binaryLength], command);
+    }
+
+    long decoded = 0;
+    DrawingDecoder decoder;
+    Command command;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < binaryLength; i++) {
+        if (decoder.decode(binary[i], command) == DRAWING_COMMAND) {
+            decoded++;
+            parseSink = command.getArgument(command.getArgumentCount() - 1) + command.getFeedRate();
+        }
+    }
+    double decoderMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    if (decoded != (long)drawing.size()) errors++;
+
+    long mismatches = 0;
+    for (size_t i = 0; i < drawing.size(); i++) {
+        double values[MAX_COMMAND_ARGUMENTS];
+        double feedRate;
+        int count = parseWithStrings(strings[i], values, feedRate);
+        Command command;
+        command.parse(drawing[i].c_str());
+
+        bool same = count == command.getArgumentCount() && (float)feedRate == (float)command.getFeedRate();
+        for (int j = 0; j < count; j++) same = same && (float)values[j] == (float)command.getArgument(j);
+        if (!same) mismatches++;
+    }
+
+    cout << left << setw(10) << "Parse" << right << " commands=" << setw(7) << drawing.size() << " bytes=" << setw(8) << (long)totalBytes
+         << " errors=" << errors << " mismatches=" << mismatches << "\n";
+    cout << left << setw(10) << "  String" << right << " ns/command=" << setw(8) << fixed << setprecision(1) << stringMicros * 1000 / drawing.size()
+         << " MB/s=" << setw(8) << totalBytes / stringMicros << "\n";
+    cout << left << setw(10) << "  Command" << right << " ns/command=" << setw(8) << parserMicros * 1000 / drawing.size()
+         << " MB/s=" << setw(8) << totalBytes / parserMicros << "\n";
+    cout << left << setw(10) << "  Binary" << right << " ns/command=" << setw(8) << decoderMicros * 1000 / drawing.size()
+         << " bytes=" << setw(8) << binaryLength << "\n";
+}
+
+void printMoveResult(const char *name, BenchmarkResult result) {
+    double moves = result.steps > 0 ? result.steps : 1;
+
+    cout << left << setw(10) << name << right
+         << " moves=" << setw(8) << result.steps
+         << " ns/move=" << setw(10) << fixed << setprecision(1) << result.elapsedMicros * 1000 / moves << "\n";
+}
+
+void printResult(const char *name, BenchmarkResult result) {
+    double steps = result.steps > 0 ? result.steps : 1;
+    double trigCalls = result.cartesianConversions * 2.0 + result.polarConversions;
+
+    cout << left << setw(10) << name << right
+         << " steps=" << setw(8) << result.steps
+         << " cartesian/step=" << setw(8) << fixed << setprecision(3) << result.cartesianConversions / steps
+         << " polar/step=" << setw(8) << result.polarConversions / steps
+         << " trig/step=" << setw(8) << trigCalls / steps
+         << " ns/step=" << setw(10) << setprecision(1) << result.elapsedMicros * 1000 / steps << "\n";
+}
+
+int main(int argc, char **argv) {
+    const char *lines[] = { "L100,100", "L-250,40", "L-10,-300", "L400,-5", "L0,0", "L600,600" };
+    const char *circles[] = { "C0,0,90", "C50,50,-170", "C-100,20,180", "C0,0,-180" };
+    const char *spirals[] = { "S200,720", "S-150,-360", "S300,1800" };
+    LineStepper lineStepper;
+    CircleStepper circleStepper;
+    SpiralStepper spiralStepper;
+
+    printResult("Line", runStepper(lineStepper, lines, sizeof(lines) / sizeof(lines[0])));
+    printResult("Circle", runStepper(circleStepper, circles, sizeof(circles) / sizeof(circles[0])));
+    printResult("Spiral", runStepper(spiralStepper, spirals, sizeof(spirals) / sizeof(spirals[0])));
+
+    // Lookahead trades a bounded amount of deviation from the line for fewer steps.  On these drawings it saves a
+    // handful of steps for about ten times the time a step, which is why it is off unless asked for.
+    lineStepper.setLookahead(4, radiusStepSize * 2);
+    circleStepper.setLookahead(4, radiusStepSize * 2);
+    printResult("Line LA4", runStepper(lineStepper, lines, sizeof(lines) / sizeof(lines[0])));
+    printResult("Circle LA4", runStepper(circleStepper, circles, sizeof(circles) / sizeof(circles[0])));
+    lineStepper.setLookahead(0, 0);
+    circleStepper.setLookahead(0, 0);
+
+    // With a segment tolerance, each "step" is a polar-linear move handed to the coordinator
+    lineStepper.setSegmentTolerance(radiusStepSize * 2);
+    circleStepper.setSegmentTolerance(radiusStepSize * 2);
+    printResult("Line SEG", runSegments(lineStepper, lines, sizeof(lines) / sizeof(lines[0])));
+    printResult("Circle SEG", runSegments(circleStepper, circles, sizeof(circles) / sizeof(circles[0])));
+
+    // runbenchmarks-large runs these again with a 4000 step packed queue, where any per-move walk of the queue shows
+    cout << "Queue of " << PendingStepQueue::getCapacity() << " steps, " << sizeof(PendingStep) << " bytes each\n";
+    printMoveResult("Setup", runMoveSetup());
+    printMoveResult("Setup fp", runFloatMoveSetup());
+    printMoveResult("Consumer", runConsumer(0));
+    printMoveResult("Cons acc", runConsumer(BENCHMARK_ACCELERATION));
+    printMoveResult("Moves", runCoordinator(0));
+    printMoveResult("Moves acc", runCoordinator(BENCHMARK_ACCELERATION));
+    runParsers();
+}
@@ -0,0 +1,215 @@
+#ifndef __IN_TEST__
+#define __IN_TEST__
+#endif
+#include "plotterController.h"
+#include "fakeStatus.h"
+#include <atomic>
+#include <iostream>
+#include <stdlib.h>
+#include <thread>
+
+#define QUEUE_STRESS_STEPS 200000
+#define COORDINATOR_STRESS_STEPS 20000
+#define STOP_ORIGIN_ROUNDS 5000
+
+using namespace std;
+
+// The producer pushes a known sequence while the consumer pops it on another thread, checking nothing is lost,
+// repeated or seen before it was fully written
+template <class Storage>
+bool stressQueue(const char *name) {
+    StepQueue<MAX_PENDING_STEPS, Storage> queue;
+    long mismatches = 0;
+
+    // Values that fit in the packed layout, so both layouts should give them back exactly
+    thread producer([&queue]() {
+        for (long i = 0; i < QUEUE_STRESS_STEPS; i++) {
+            while (queue.isFull()) this_thread::yield();
+            Storage &slot = queue.back();
+            slot.setStep(i % 30000, -(i % 20000), (i & 1) != 0, i % 30000);
+            slot.setMaxEntrySpeedSquared((i % 1000) * (i % 1000));
+            slot.setPlannedEntrySpeedSquared((i % 900) * (i % 900));
+            queue.push();
+        }
+    });
+
+    thread consumer([&queue, &mismatches]() {
+        for (long i = 0; i < QUEUE_STRESS_STEPS; i++) {
+            while (queue.isEmpty()) this_thread::yield();
+            Storage &slot = queue.peek(0);
+            if (slot.getRadiusStep() != i % 30000 || slot.getAzimuthStep() != -(i % 20000) || slot.isFast() != ((i & 1) != 0) || slot.getInterval() != (unsigned long)(i % 30000)
+                || slot.getMaxEntrySpeedSquared() != (unsigned long)(i % 1000) * (i % 1000)
+                || slot.getPlannedEntrySpeedSquared() != (unsigned long)(i % 900) * (i % 900)) {
+                mismatches++;
+            }
+            queue.pop();
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    cout << "Queue (" << name << ", " << sizeof(Storage) << " bytes a step): " << QUEUE_STRESS_STEPS << " steps, " << mismatches
+         << " mismatches, at most " << queue.getHighWaterMark() << " of " << queue.getCapacity() << " waiting\n";
+    return mismatches == 0 && queue.getHighWaterMark() <= queue.getCapacity();
+}
+
+// The planner side adds steps, and pauses, resumes and changes speed, while the motor side runs move() in a loop, the
+// same split as core 0 and core 1 on the RP2040.  With the axes interlocked, the radius motor has to make up for the
+// azimuth's drag as well.  With acceleration, the planner also rewrites the planned speeds of queued steps while the
+// motor side reads them.
+bool stressCoordinator(const int interlocked, const double acceleration) {
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    PolarMotorCoordinator coordinator(&radiusMotor, &azimuthMotor, interlocked, 0, acceleration > 0 ? 20 : 1, 1.0);
+    coordinator.setAcceleration(acceleration);
+    atomic<bool> finished(false);
+    long radiusTotal = 0, azimuthTotal = 0;
+
+    thread motors([&coordinator, &finished]() {
+        while (!finished.load() || coordinator.isMoving()) {
+            coordinator.move();
+            if (!coordinator.isMoving()) this_thread::yield();
+        }
+    });
+
+    srand(1);
+    bool paused = false;
+    for (long i = 0; i < COORDINATOR_STRESS_STEPS; i++) {
+        long radiusStep = rand() % 7 - 3;
+        long azimuthStep = rand() % 7 - 3;
+
+        // A paused coordinator never drains, so resume rather than wait forever on a full queue
+        if (paused && !coordinator.canAddSteps()) {
+            coordinator.resume();
+            paused = false;
+        }
+        while (!coordinator.canAddSteps()) this_thread::yield();
+        coordinator.addSteps(radiusStep, azimuthStep, (i & 1) != 0);
+        radiusTotal += radiusStep;
+        azimuthTotal += azimuthStep;
+
+        if (i % 1000 == 0) {
+            coordinator.pause();
+            paused = true;
+        }
+        if (paused && (i % 1000 == 10 || i == COORDINATOR_STRESS_STEPS - 1)) {
+            coordinator.resume();
+            paused = false;
+        }
+        if (i % 5000 == 0) coordinator.changeStepInterval(i % 2);
+    }
+    finished.store(true);
+    motors.join();
+
+    Step position = coordinator.getCurrentPosition();
+    long radiusMotorTotal = radiusTotal - interlocked * azimuthTotal;
+    cout << "Coordinator queue: at most " << coordinator.getQueueHighWaterMark() << " of " << coordinator.getQueueCapacity() << " waiting, "
+         << coordinator.getQueueUnderruns() << " underruns, " << coordinator.getTimelineGapMicros() << "us of gaps\n";
+    cout << "Coordinator (interlocked " << interlocked << ", acceleration " << acceleration << "): " << COORDINATOR_STRESS_STEPS << " steps, expected " << radiusTotal
+         << "," << azimuthTotal << ", at " << position.getRadiusStep() << "," << position.getAzimuthStep() << ", radius motor at "
+         << radiusMotor.getPosition() << " of " << radiusMotorTotal << "\n";
+    return position.getRadiusStep() == radiusTotal && position.getAzimuthStep() == azimuthTotal && radiusMotor.getPosition() == radiusMotorTotal;
+}
+
+// Each round stops an idle coordinator, declares an origin and queues a few steps, while the motor side runs move() in
+// a loop.  The stop comes before the origin and the steps, so it has nothing to drop, and every round has to end up
+// at its own steps from the new origin.
+bool stressStopThenOrigin() {
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    PolarMotorCoordinator coordinator(&radiusMotor, &azimuthMotor, 0, 0, 1, 1.0);
+    atomic<bool> finished(false);
+    long misplaced = 0;
+
+    thread motors([&coordinator, &finished]() {
+        while (!finished.load() || coordinator.isMoving()) {
+            coordinator.move();
+        }
+    });
+
+    srand(2);
+    for (long round = 0; round < STOP_ORIGIN_ROUNDS; round++) {
+        while (coordinator.isMoving()) this_thread::yield();
+        coordinator.stop();
+        while (!coordinator.declareOrigin()) this_thread::yield();
+        long radiusTotal = 0, azimuthTotal = 0;
+        for (int i = 0; i < 3; i++) {
+            long radiusStep = rand() % 7 - 3;
+            long azimuthStep = rand() % 7 - 3;
+            while (!coordinator.canAddSteps()) this_thread::yield();
+            coordinator.addSteps(radiusStep, azimuthStep, true);
+            radiusTotal += radiusStep;
+            azimuthTotal += azimuthStep;
+        }
+
+        while (coordinator.isMoving()) this_thread::yield();
+        Step position = coordinator.getCurrentPosition();
+        if (position.getRadiusStep() != radiusTotal || position.getAzimuthStep() != azimuthTotal)
+            misplaced++;
+    }
+    finished.store(true);
+    motors.join();
+
+    cout << "Stop then origin: " << STOP_ORIGIN_ROUNDS << " rounds, " << misplaced << " not at their steps from the origin\n";
+    return misplaced == 0;
+}
+
+// A binary drawing whose differences add up past the largest argument is refused, rather than overflowing
+bool checkDecoderRange() {
+    // The header, at no decimals, then L commands of one argument that each add the largest difference
+    const uint8_t drawing[] = { 'P', 'P', 'D', DRAWING_VERSION, 0, 100, 100,
+                                0x11, 0xfe, 0xff, 0xff, 0xff, 0x07,
+                                0x11, 0xfe, 0xff, 0xff, 0xff, 0x07 };
+    DrawingDecoder decoder;
+    Command command;
+    int commands = 0;
+    DrawingDecodeResult result = DRAWING_NEED_MORE;
+    for (unsigned int i = 0; i < sizeof(drawing) && result != DRAWING_ERROR; i++) {
+        result = decoder.decode(drawing[i], command);
+        if (result == DRAWING_COMMAND) commands++;
+    }
+
+    cout << "Decoder range: " << commands << " commands, " << (result == DRAWING_ERROR ? decoder.getError() : "no error") << "\n";
+    return commands == 1 && result == DRAWING_ERROR;
+}
+
+// Commands left over from one drawing must not be drawn at the start of the next
+bool checkNewDrawingClearsCommands() {
+    Print print;
+    StatusUpdater status;
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    PolarMotorCoordinator coordinator(&radiusMotor, &azimuthMotor, 0, 200, 2000, 2.0);
+    PlotterController plotter(print, status, 1000, 650, &coordinator);
+    String first("First");
+    String second("Second");
+    plotter.calibrate(1000.0 / 10500, 2 * PI / 4810);
+    plotter.newDrawing(first);
+    String line("L100,100");
+    String circle("C0,0,90");
+    plotter.addCommand(line);
+    plotter.addCommand(circle);
+    bool leftOver = plotter.canCycle();
+    plotter.newDrawing(second);
+    bool carriedOver = plotter.canCycle();
+
+    cout << "New drawing: " << (leftOver ? "commands" : "no commands") << " before, " << (carriedOver ? "commands" : "no commands") << " after\n";
+    return leftOver && !carriedOver;
+}
+
+int main(int argc, char **argv) {
+    initialize_mock_arduino();
+
+    bool passed = stressQueue<QueuedStep>("wide");
+    passed = stressQueue<PackedQueuedStep>("packed") && passed;
+    passed = stressCoordinator(0, 0) && passed;
+    passed = stressCoordinator(-2, 0) && passed;
+    passed = stressCoordinator(-2, 1000000) && passed;
+    passed = stressStopThenOrigin() && passed;
+    passed = checkNewDrawingClearsCommands() && passed;
+    passed = checkDecoderRange() && passed;
+
+    cout << (passed ? "PASSED" : "FAILED") << "\n";
+    return passed ? 0 : 1;
+}
@@ -3,14 +3,23 @@
 #endif
 #include "plotterController.h"
 #include "fakeStatus.h"
+#include "fakeStepTimer.h"
+#include "fakeStepPins.h"
+#include "fileCommandSource.h"
 #include <iomanip>
 #include <iostream>
 #include <stdlib.h>
+#include <string.h>
 
 #define MAX_RADIUS 1000
 #define MARBLE_SIZE_IN_RADIUS_STEPS 650
 #define MAX_RADIUS_STEPS 10500
 #define FULL_CIRCLE_AZIMUTH_STEPS 4810
+#define MINIMUM_STEP_INTERVAL 200
+#define MAXIMUM_STEP_INTERVAL 2000
+#define SLOW_STEP_MULTIPLIER 2.0
+#define CYCLE_MICROS 1000
+#define BINARY_CHUNK_SIZE 64
 
 const double maxRadius = MAX_RADIUS;
 const double radiusStepSize = maxRadius / MAX_RADIUS_STEPS;
@@ -23,7 +32,12 @@ int main(int argc, char **argv) {
 
     Print print;
     StatusUpdater status;
-    PlotterController plotter(print, status, MAX_RADIUS, MARBLE_SIZE_IN_RADIUS_STEPS);
+    StepDirMotor radiusMotor(2, 3);
+    StepDirMotor azimuthMotor(4, 5);
+    PolarMotorCoordinator coordinator(&radiusMotor, &azimuthMotor, 0, MINIMUM_STEP_INTERVAL, MAXIMUM_STEP_INTERVAL, SLOW_STEP_MULTIPLIER);
+    FakeStepTimer timer;
+    FakeStepPins pins;
+    PlotterController plotter(print, status, MAX_RADIUS, MARBLE_SIZE_IN_RADIUS_STEPS, &coordinator);
     String drawing("TestDrawing");
 
     cout << "Initializing MAX_RADIUS: " << MAX_RADIUS << "\n";
@@ -31,16 +45,91 @@ int main(int argc, char **argv) {
     cout << "Initializing AZIMUTH_STEP_SIZE: " << setprecision(12) << azimuthStepSize << "\n";
     cout << "Initializing MARBLE_SIZE_IN_RADIUS_STEPS: " << MARBLE_SIZE_IN_RADIUS_STEPS << "\n";
     cout << "Setting drawing: " << drawing.c_str() << "\n";
+    coordinator.init();
+    coordinator.begin();
+    coordinator.setStepPins(&pins);
+    coordinator.attachTimer(&timer);
     plotter.calibrate(radiusStepSize, azimuthStepSize);
     plotter.newDrawing(drawing);
-    for (int i = 1; i < argc; i++) {
-        String command(argv[i]);
-        cout << "Adding command: " << command.c_str() << "\n";
-        plotter.addCommand(command);
+
+    // "-f file" streams the drawing from a text file, "-b file" from a binary one, otherwise the arguments are the commands
+    FileCommandSource *file = NULL;
+    FILE *binary = NULL;
+    if (argc == 3 && strcmp(argv[1], "-f") == 0) {
+        file = new FileCommandSource(argv[2]);
+        if (!file->isOpen()) {
+            cout << "Unable to open " << argv[2] << "\n";
+            return 1;
+        }
+        cout << "Streaming commands from: " << argv[2] << "\n";
+        plotter.setCommandSource(file);
+    } else if (argc == 3 && strcmp(argv[1], "-b") == 0) {
+        binary = fopen(argv[2], "rb");
+        if (!binary) {
+            cout << "Unable to open " << argv[2] << "\n";
+            return 1;
+        }
+        cout << "Streaming binary drawing from: " << argv[2] << "\n";
     }
 
+    // Commands are offered to the controller as it has room for them, the way a sender holds off while the buffer is full
+    int nextArg = file || binary ? argc : 1;
+    uint8_t chunk[BINARY_CHUNK_SIZE];
+    int chunkLength = 0;
+    int chunkIndex = 0;
+    long binaryBytes = 0;
+    long refusals = 0;
     cout << "Executing commands\n";
-    while (plotter.canCycle()) {
+    // The motors run from the fake timer's alarm, while the controller keeps the queue filled in between
+    while (nextArg < argc || binary || plotter.canCycle() || coordinator.isMoving()) {
+        while (nextArg < argc) {
+            String command(argv[nextArg]);
+            if (!plotter.addCommand(command)) {
+                refusals++;
+                break;
+            }
+            cout << "Adding command: " << command.c_str() << "\n";
+            nextArg++;
+        }
+
+        // The binary drawing arrives in chunks, as it would over serial, and is only read on as the controller takes it
+        while (binary) {
+            if (chunkIndex >= chunkLength) {
+                chunkLength = fread(chunk, 1, BINARY_CHUNK_SIZE, binary);
+                chunkIndex = 0;
+                if (chunkLength <= 0) {
+                    fclose(binary);
+                    binary = NULL;
+                    break;
+                }
+            }
+
+            int taken = plotter.addDrawingBytes(&chunk[chunkIndex], chunkLength - chunkIndex);
+            chunkIndex += taken;
+            binaryBytes += taken;
+            if (chunkIndex < chunkLength) {
+                refusals++;
+                break;
+            }
+        }
+
         plotter.performCycle();
+        timer.advance(CYCLE_MICROS);
+    }
+
+    Step motorPosition = coordinator.getCurrentPosition();
+    cout << "MOTORS: " << motorPosition.getRadiusStep() << "," << motorPosition.getAzimuthStep() << " after " << timer.getAlarmCount() << " alarms, "
+         << timer.now() / 1000 << "ms\n";
+    cout << "TIMELINE: " << coordinator.getTimelineGapMicros() << "us of gaps between moves, " << coordinator.getQueueUnderruns()
+         << " underruns, at most " << coordinator.getQueueHighWaterMark() << " of " << coordinator.getQueueCapacity() << " steps queued\n";
+    cout << "PINS: " << pins.getWriteCount() << " writes, " << pins.countRisingEdges(2) << " radius and " << pins.countRisingEdges(4)
+         << " azimuth pulses, " << pins.countAlignedRisingEdges(2, 4) << " together, " << (pins.getState() == 0 ? "all low" : "left high") << "\n";
+    if (file) {
+        cout << "COMMANDS: " << file->getLineCount() << " streamed from file\n";
+        delete file;
+    } else if (binaryBytes > 0) {
+        cout << "COMMANDS: " << binaryBytes << " bytes of binary drawing, held off " << refusals << " times while the buffer was full\n";
+    } else {
+        cout << "COMMANDS: " << (argc - 1) << " added, held off " << refusals << " times while the buffer was full\n";
     }
 }
\ No newline at end of file